@@ -0,0 +1,152 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+
+#include "bsp_actuator.h"
+
+#define ACTUATOR_QUEUE_LEN      (8)
+#define ACTUATOR_TASK_PRIORITY  (4)     /* below the LVGL task, a fade never delays a frame */
+#define ACTUATOR_NONE           (-1)
+
+typedef struct {
+    uint8_t id;
+    uint8_t percent;
+} actuator_req_t;
+
+typedef struct {
+    bsp_actuator_config_t config;
+    int16_t target;
+    int16_t applied;
+    int16_t late;           /* set by a caller that found the queue full */
+    bool pending;
+    int64_t last_us;
+} actuator_t;
+
+static const char *TAG = "bsp_actuator";
+static actuator_t actuators[BSP_ACTUATOR_MAX];
+static uint8_t actuator_num;
+static QueueHandle_t queue;
+static bsp_actuator_stats_t stats;
+
+static void merge(actuator_t *a, uint8_t percent)
+{
+    if (a->pending) {
+        stats.merged++;
+    }
+    a->target = percent;
+    a->pending = true;
+}
+
+static void apply(actuator_t *a)
+{
+    const bsp_actuator_config_t *cfg = &a->config;
+    uint32_t percent = cfg->invert ? 100 - a->target : a->target;
+    uint32_t duty = BIT(cfg->duty_resolution) * percent / 100;
+
+    a->pending = false;
+    a->applied = a->target;
+    a->last_us = esp_timer_get_time();
+    stats.applied++;
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    /* retarget from wherever the running fade got to instead of waiting for its end */
+    ledc_fade_stop(cfg->speed_mode, cfg->channel);
+#endif
+    if (cfg->fade_ms) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ledc_set_fade_with_time(cfg->speed_mode, cfg->channel, duty, cfg->fade_ms));
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ledc_fade_start(cfg->speed_mode, cfg->channel, LEDC_FADE_NO_WAIT));
+    } else {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ledc_set_duty_and_update(cfg->speed_mode, cfg->channel, duty, 0));
+    }
+}
+
+static void actuator_task(void *arg)
+{
+    TickType_t wait = portMAX_DELAY;
+
+    while (true) {
+        actuator_req_t req;
+        if (xQueueReceive(queue, &req, wait) == pdTRUE) {
+            do {
+                merge(&actuators[req.id], req.percent);
+            } while (xQueueReceive(queue, &req, 0) == pdTRUE);
+        }
+
+        wait = portMAX_DELAY;
+        int64_t now = esp_timer_get_time();
+        for (uint8_t i = 0; i < actuator_num; i++) {
+            actuator_t *a = &actuators[i];
+            int16_t late = __atomic_exchange_n(&a->late, ACTUATOR_NONE, __ATOMIC_RELAXED);
+            if (late != ACTUATOR_NONE) {
+                merge(a, late);
+            }
+            if (!a->pending) {
+                continue;
+            }
+            if (a->target == a->applied) {
+                a->pending = false;
+                continue;
+            }
+            /* rate limit: hold the newest target until the interval is over */
+            int64_t left_us = a->last_us + a->config.min_interval_ms * 1000 - now;
+            if (left_us > 0) {
+                TickType_t ticks = pdMS_TO_TICKS((left_us + 999) / 1000) + 1;
+                wait = (ticks < wait) ? ticks : wait;
+                continue;
+            }
+            apply(a);
+        }
+    }
+}
+
+esp_err_t bsp_actuator_add(const bsp_actuator_config_t *config, uint8_t *ret_id)
+{
+    ESP_RETURN_ON_FALSE(config && ret_id, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(actuator_num < BSP_ACTUATOR_MAX, ESP_ERR_NO_MEM, TAG, "no free actuator");
+
+    if (!queue) {
+        queue = xQueueCreate(ACTUATOR_QUEUE_LEN, sizeof(actuator_req_t));
+        ESP_RETURN_ON_FALSE(queue, ESP_ERR_NO_MEM, TAG, "no mem for queue");
+        BaseType_t ret = xTaskCreate(actuator_task, "actuator", 2 * 1024, NULL, ACTUATOR_TASK_PRIORITY, NULL);
+        ESP_RETURN_ON_FALSE(pdPASS == ret, ESP_ERR_NO_MEM, TAG, "no mem for task");
+    }
+
+    actuator_t *a = &actuators[actuator_num];
+    memset(a, 0, sizeof(actuator_t));
+    a->config = *config;
+    a->applied = ACTUATOR_NONE;
+    a->late = ACTUATOR_NONE;
+    *ret_id = actuator_num;
+    __atomic_store_n(&actuator_num, actuator_num + 1, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+esp_err_t bsp_actuator_set(uint8_t id, uint8_t percent)
+{
+    ESP_RETURN_ON_FALSE(id < actuator_num, ESP_ERR_INVALID_ARG, TAG, "invalid actuator");
+
+    actuator_req_t req = {
+        .id = id,
+        .percent = (percent > 100) ? 100 : percent,
+    };
+    stats.requests++;
+    if (xQueueSend(queue, &req, 0) != pdTRUE) {
+        /* the task is behind and has work queued anyway, it picks this up after the queue */
+        __atomic_store_n(&actuators[id].late, req.percent, __ATOMIC_RELAXED);
+        stats.overflows++;
+    }
+    return ESP_OK;
+}
+
+void bsp_actuator_get_stats(bsp_actuator_stats_t *out, bool reset)
+{
+    *out = stats;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+    }
+}
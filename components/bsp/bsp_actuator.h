@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/ledc.h"
+#include "esp_err.h"
+
+#define BSP_ACTUATOR_MAX        (4)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    ledc_mode_t speed_mode;
+    ledc_channel_t channel;             /* already configured, with the fade function installed */
+    ledc_timer_bit_t duty_resolution;
+    bool invert;                        /* output is active low */
+    uint16_t fade_ms;                   /* ramp time to every new target, 0 to jump */
+    uint16_t min_interval_ms;           /* targets arriving faster are merged, the last one wins */
+} bsp_actuator_config_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t merged;        /* replaced by a newer target before they were applied */
+    uint32_t applied;
+    uint32_t overflows;     /* requests that found the queue full, they still get applied */
+} bsp_actuator_stats_t;
+
+/**
+ * Hand a PWM output to the actuator service, its task is started with the first one.
+ */
+esp_err_t bsp_actuator_add(const bsp_actuator_config_t *config, uint8_t *ret_id);
+
+/**
+ * Queue a new target for `id` and return, the hardware fade runs in the actuator task.
+ * Safe to call from the render task and UI event callbacks.
+ */
+esp_err_t bsp_actuator_set(uint8_t id, uint8_t percent);
+
+void bsp_actuator_get_stats(bsp_actuator_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,7 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
 #include "esp_check.h"
 #include "esp_log.h"
 #include "esp_system.h"
@@ -27,9 +28,43 @@ static int64_t end_us = 0;
 static int64_t diff_us = 0;
 static size_t dir = 0;// -1 -> left 1-> right
 
+/* the A/B state of the last edge, and the edges lost since the start, 2 per detent */
+static uint8_t quad_state = 0;
+static uint32_t overflows_seen = 0;
+static uint32_t overflows_unseen = 0;
+static uint32_t lost_edges = 0;
+static bsp_encoder_stats_t stats;
+
 static bsp_encoder_cb_t cbs[bsp_encoder_EVENT_MAX];
 static void *cb_user_datas[bsp_encoder_EVENT_MAX];
 
+/**
+ * Follow the A/B levels the ISR sampled for an edge. A valid edge flips exactly one of them; no
+ * change or two changes mean edges in between never got here. Edges the ISR dropped are counted
+ * there exactly; an invalid transition without a drop since the last one is a glitch and counts
+ * as one lost edge.
+ */
+static void quad_track(int a, int b)
+{
+    uint8_t state = (a << 1) | b;
+    uint8_t diff = state ^ quad_state;
+    uint32_t overflows = stats.overflows;
+
+    overflows_unseen += overflows - overflows_seen;
+    lost_edges += overflows - overflows_seen;
+    overflows_seen = overflows;
+    if (diff == 0 || diff == 3) {
+        stats.invalid++;
+        if (overflows_unseen) {
+            overflows_unseen = 0;
+        } else {
+            lost_edges++;
+        }
+    }
+    quad_state = state;
+    stats.missed_detents = (lost_edges + 1) / 2;
+}
+
 static void gpioTaskExample(void *arg)
 {
     uint32_t ioNum = (uint32_t) arg;
@@ -37,11 +72,19 @@ static void gpioTaskExample(void *arg)
     phb_value = gpio_get_level(GPIO_CNT_B);
     pha_value_old = pha_value;
     phb_value_old = phb_value;
+    quad_state = (pha_value << 1) | phb_value;
     bsp_encoder_event_t event = bsp_encoder_EVENT_DEC;
     while (1) {
         if (xQueueReceive(gpioEventQueue, &ioNum, portMAX_DELAY)) {
+            /* the levels the ISR sampled at the edge, not the ones the pins have by now */
+            int level_a = (ioNum >> 1) & 1;
+            int level_b = ioNum & 1;
+            ioNum >>= 2;
+            stats.edges++;
+            quad_track(level_a, level_b);
+
             if (ioNum == GPIO_CNT_A) {
-                pha_value = gpio_get_level(GPIO_CNT_A);
+                pha_value = level_a;
                 if (pha_value != pha_value_old) {
                     pha_value_old = pha_value;
                     pha_value_change = 1;
@@ -56,7 +99,7 @@ static void gpioTaskExample(void *arg)
                     }
                 }
             } else {
-                phb_value = gpio_get_level(GPIO_CNT_B);
+                phb_value = level_b;
                 if (phb_value != phb_value_old) {
                     phb_value_old = phb_value;
                     phb_value_change = 1;
@@ -87,7 +130,12 @@ static void gpioTaskExample(void *arg)
 static void IRAM_ATTR intrHandler (void *arg)
 {
     uint32_t gpio_num = (uint32_t)arg;
-    xQueueSendFromISR(gpioEventQueue, &gpio_num, NULL);
+    /* gpio_get_level() isn't in IRAM, read the input register directly */
+    uint32_t event = (gpio_num << 2) | (gpio_ll_get_level(&GPIO, GPIO_CNT_A) << 1)
+                     | gpio_ll_get_level(&GPIO, GPIO_CNT_B);
+    if (xQueueSendFromISR(gpioEventQueue, &event, NULL) != pdTRUE) {
+        stats.overflows++;
+    }
 }
 
 esp_err_t bsp_encoder_init(int gpio_a, int gpio_b)
@@ -121,6 +169,11 @@ int32_t bsp_encoder_get_value(void)
     return EC11_Value;
 }
 
+void bsp_encoder_get_stats(bsp_encoder_stats_t *out)
+{
+    *out = stats;
+}
+
 esp_err_t bsp_btn_init(int gpio_num)
 {
     ESP_RETURN_ON_FALSE(gpio_num != GPIO_NUM_NC, ESP_ERR_INVALID_ARG, TAG, "Invalid gpio_num");
@@ -20,8 +20,16 @@ typedef enum {
 
 typedef void (* bsp_encoder_cb_t)(void *);
 
+typedef struct {
+    uint32_t edges;             /* edges taken from the queue */
+    uint32_t overflows;         /* edges dropped by the ISR, the queue was full */
+    uint32_t invalid;           /* edges whose A/B state, sampled in the ISR, skipped or undid a step */
+    uint32_t missed_detents;    /* overflows plus glitches, 2 edges per detent, rounded up */
+} bsp_encoder_stats_t;
+
 esp_err_t bsp_encoder_init(int gpio_a, int gpio_b);
 int32_t bsp_encoder_get_value(void);
+void bsp_encoder_get_stats(bsp_encoder_stats_t *stats);
 esp_err_t bsp_encoder_register_callback(bsp_encoder_event_t event, bsp_encoder_cb_t cb, void *user_data);
 
 esp_err_t bsp_btn_init(int gpio_num);
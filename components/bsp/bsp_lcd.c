@@ -10,8 +10,10 @@
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "lcd_panel_gc9a01.h"
+#include "bsp_actuator.h"
 #include "bsp_lcd.h"
 
 #define LCD_HOST                (SPI2_HOST)
@@ -38,11 +40,17 @@
 #define LEDC_CHANNEL            (LEDC_CHANNEL_0)
 #define LEDC_DUTY_RES           (LEDC_TIMER_13_BIT) // Set duty resolution to 13 bits
 #define LEDC_FREQUENCY          (5000) // Frequency in Hertz. Set frequency at 5 kHz
+#define BACKLIGHT_FADE_MS       (60)
+#define BACKLIGHT_INTERVAL_MS   (30)
 
 static char *TAG = "bsp_lcd";
 static esp_lcd_panel_handle_t panel_handle = NULL;
 static bsp_lcd_trans_done_cb_t on_trans_done = NULL;
 static SemaphoreHandle_t flush_ready = NULL;
+static int64_t te_last_us = 0;
+static uint32_t te_period_us = 0;
+static uint8_t backlight_id = 0;
+static bool backlight_ready = false;
 
 static bool bsp_lcd_on_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
 static void bsp_lcd_tear_gpio_isr_handler(void *arg);
@@ -111,12 +119,22 @@ esp_lcd_panel_handle_t bsp_lcd_init(void)
             .timer_sel      = LEDC_TIMER,
             .intr_type      = LEDC_INTR_DISABLE,
             .gpio_num       = LEDC_OUTPUT_IO,
-            .duty           = 0,
+            .duty           = BIT(LEDC_DUTY_RES), // active low, dark until the first fade
             .hpoint         = 0
         };
         ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
         ESP_ERROR_CHECK(ledc_fade_func_install(0));
 
+        bsp_actuator_config_t backlight_config = {
+            .speed_mode = LEDC_MODE,
+            .channel = LEDC_CHANNEL,
+            .duty_resolution = LEDC_DUTY_RES,
+            .invert = true,
+            .fade_ms = BACKLIGHT_FADE_MS,
+            .min_interval_ms = BACKLIGHT_INTERVAL_MS,
+        };
+        ESP_ERROR_CHECK(bsp_actuator_add(&backlight_config, &backlight_id));
+        backlight_ready = true;
         bsp_lcd_set_brightness(0);//100 20221221 zhongxl
     }
 
@@ -146,10 +164,9 @@ void bsp_lcd_trans_done_cb_register(bsp_lcd_trans_done_cb_t cb)
 
 void bsp_lcd_set_brightness(uint8_t percent)
 {
-    percent = (percent > 100) ? 100 : percent;
-    percent = 100 - percent;
-    uint32_t duty = BIT(LEDC_DUTY_RES) * percent / 100;
-    ESP_ERROR_CHECK(ledc_set_duty_and_update(LEDC_MODE, LEDC_CHANNEL, duty, 0));
+    if (backlight_ready) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(bsp_actuator_set(backlight_id, percent));
+    }
 }
 
 void bsp_lcd_wait_flush_ready(void)
@@ -157,6 +174,19 @@ void bsp_lcd_wait_flush_ready(void)
     xSemaphoreTake(flush_ready, portMAX_DELAY);
 }
 
+void bsp_lcd_sleep(bool sleep)
+{
+    ESP_ERROR_CHECK(lcd_panel_gc9a01_sleep(panel_handle, sleep));
+    if (sleep) {
+        te_last_us = 0;
+    }
+}
+
+uint32_t bsp_lcd_get_te_period_us(void)
+{
+    return te_period_us;
+}
+
 static bool bsp_lcd_on_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
     if (on_trans_done) {
@@ -173,6 +203,14 @@ static void bsp_lcd_tear_gpio_isr_handler(void *arg)
 
     if (gpio_get_level(gpio_num)) {
         xSemaphoreGiveFromISR(flush_ready, &need_yield);
+
+        /* average the frame period of the panel, gaps from a stopped panel are skipped */
+        int64_t now = esp_timer_get_time();
+        uint32_t period = now - te_last_us;
+        if (te_last_us && period < 100 * 1000) {
+            te_period_us = te_period_us ? (te_period_us * 7 + period) / 8 : period;
+        }
+        te_last_us = now;
     }
     else {
         xSemaphoreTakeFromISR(flush_ready, &need_yield);
@@ -16,10 +16,24 @@ esp_lcd_panel_handle_t bsp_lcd_init(void);
 
 void  bsp_lcd_trans_done_cb_register(bsp_lcd_trans_done_cb_t callback);
 
+/**
+ * Fade the backlight to `percent`, returns right away. Calls in quick succession are merged
+ * by the actuator service.
+ */
 void bsp_lcd_set_brightness(uint8_t percent);
 
 void bsp_lcd_wait_flush_ready(void);
 
+/**
+ * Put the panel into sleep-in (display off) or wake it up, no TE edges arrive while it sleeps.
+ */
+void bsp_lcd_sleep(bool sleep);
+
+/**
+ * @return the measured TE period of the panel in us, 0 until it has been seen
+ */
+uint32_t bsp_lcd_get_te_period_us(void);
+
 #ifdef __cplusplus
 }
 #endif
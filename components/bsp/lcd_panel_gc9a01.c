@@ -355,3 +355,19 @@ static esp_err_t panel_gc9a01_disp_off(esp_lcd_panel_t *panel, bool off)
 }
 #endif
 
+
+esp_err_t lcd_panel_gc9a01_sleep(esp_lcd_panel_handle_t panel, bool sleep)
+{
+    gc9a01_panel_t *gc9a01 = __containerof(panel, gc9a01_panel_t, base);
+    esp_lcd_panel_io_handle_t io = gc9a01->io;
+    if (sleep) {
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_DISPOFF, NULL, 0);
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPIN, NULL, 0);
+        vTaskDelay(pdMS_TO_TICKS(5));
+    } else {
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0);
+        vTaskDelay(pdMS_TO_TICKS(120));
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_DISPON, NULL, 0);
+    }
+    return ESP_OK;
+}
@@ -24,6 +24,18 @@ extern "C" {
  */
 esp_err_t lcd_new_panel_gc9a01(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel);
 
+/**
+ * @brief Enter or leave sleep-in mode, the frame memory keeps its content while sleeping
+ *
+ * @note Leaving sleep blocks for the 120 ms the panel needs before it accepts frame data again
+ *
+ * @param[in] panel LCD panel handle of a gc9a01
+ * @param[in] sleep true to turn the display off and enter sleep, false to wake it up
+ * @return
+ *          - ESP_OK                on success
+ */
+esp_err_t lcd_panel_gc9a01_sleep(esp_lcd_panel_handle_t panel, bool sleep);
+
 #ifdef __cplusplus
 }
 #endif
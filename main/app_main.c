@@ -18,15 +18,36 @@
 #include "nvs_flash.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#ifdef CONFIG_PM_ENABLE
+#include "esp_idf_version.h"
+#include "esp_pm.h"
+#endif
 
 #include "bsp_lcd.h"
+#include "bsp_actuator.h"
+#include "bsp_indev.h"
 #include "lvgl_port.h"
+#include "lvgl_dma.h"
+#include "dlog.h"
+#include "dev_state.h"
 #include "ui/ui.h"
+#include "ui/ui_asset_pool.h"
+#include "ui/ui_census.h"
+#include "ui/ui_img_runs.h"
+#include "ui/ui_coalesce.h"
+#include "ui/ui_weather.h"
 
 static const char *TAG = "main";
+DLOG_TAG_DEFINE(control_tag, "control", 10);
 
 
 #define MEMORY_MONITOR 1
+#define COMPRESS_FB 0   // keep the frame compressed in RAM instead of two full frame buffers
+#define DLOG_BINARY 0   // print raw log records, decode them with tools/dlog_decode.py
+#define VIRTUAL_TICK 0  // replay the first VIRTUAL_RUN_MS of UI time as fast as possible and print the frame cost
+#define VIRTUAL_RUN_MS (5000)
+#define DMA_BLEND 0      // large opaque fills and copies into the draw buffer by GDMA
+#define REDRAW_HEATMAP 0 // tint redrawn areas on the panel and print the redraws per tile with the monitor
 
 #if MEMORY_MONITOR
 
@@ -139,6 +160,36 @@ exit:    //Common return path
     return ret;
 }
 
+#if REDRAW_HEATMAP
+#define HEAT_COLS ((LCD_H_RES + LVGL_PORT_HEATMAP_TILE - 1) / LVGL_PORT_HEATMAP_TILE)
+#define HEAT_ROWS ((LCD_V_RES + LVGL_PORT_HEATMAP_TILE - 1) / LVGL_PORT_HEATMAP_TILE)
+
+/**
+ * One character per tile for the share of frames that redrew it, from ' ' (never) to '@'
+ * (every frame). Counts above the frames mean overlapping areas drew the tile more than once.
+ */
+static void print_heatmap(void)
+{
+    static const char ramp[] = " .:-=+*#%@";
+    static uint16_t counts[HEAT_COLS * HEAT_ROWS];
+    uint32_t frames = lvgl_port_get_heatmap(counts, true);
+    uint32_t total = 0;
+    printf("Redraws per tile over %u frames\n", frames);
+    for (int y = 0; y < HEAT_ROWS; y++) {
+        char line[HEAT_COLS + 1];
+        for (int x = 0; x < HEAT_COLS; x++) {
+            uint16_t n = counts[y * HEAT_COLS + x];
+            int level = frames ? LV_MIN(n * (sizeof(ramp) - 2) / frames, sizeof(ramp) - 2) : 0;
+            line[x] = (n && !level) ? ramp[1] : ramp[level];
+            total += n;
+        }
+        line[HEAT_COLS] = '\0';
+        printf("|%s|\n", line);
+    }
+    printf("Tile redraws\t%u\n", total);
+}
+#endif
+
 static void monitor_task(void *arg)
 {
     (void) arg;
@@ -157,6 +208,57 @@ static void monitor_task(void *arg)
                heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL),
                heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
 
+        lvgl_port_frame_stats_t frame;
+        lvgl_port_get_frame_stats(&frame, true);
+        printf("Frames\t%u\tlast %u ms\tavg %u ms\tmax %u ms\n", frame.frames, frame.last_ms, frame.avg_ms, frame.max_ms);
+        ui_asset_pool_stats_t pool;
+        ui_asset_pool_get_stats(&pool);
+        printf("Asset pool\t%u/%u B\tresident %u\trejected %u\tcopied %u B\n",
+               pool.used, pool.budget, pool.resident, pool.rejected, pool.copied_bytes);
+        ui_img_runs_stats_t runs;
+        ui_img_runs_get_stats(&runs);
+        printf("Image runs\t%u assets\t%u B\trejected %u\tblits %u\tfallbacks %u\n",
+               runs.assets, runs.bytes, runs.rejected, runs.blits, runs.fallbacks);
+        ui_sprite_stats_t sprite;
+        if (ui_weather_get_sprite_stats(&sprite)) {
+            printf("Weather sprite\t%u/%u B\tplayed %u\tskipped %u\tinvalidated %u px\n",
+                   sprite.sheet_bytes, sprite.raw_bytes, sprite.played, sprite.skipped, sprite.inv_px);
+        }
+        printf("Log records dropped\t%u\n", dlog_get_dropped());
+        printf("Value changes elided\t%u\n", ui_coalesce_get_elided(NULL));
+        bsp_actuator_stats_t act;
+        bsp_actuator_get_stats(&act, true);
+        bsp_encoder_stats_t enc;
+        bsp_encoder_get_stats(&enc);
+        printf("Encoder edges\t%u\toverflows %u\tinvalid %u\tmissed detents %u\n",
+               enc.edges, enc.overflows, enc.invalid, enc.missed_detents);
+        printf("Actuator requests\t%u\tmerged %u\tapplied %u\toverflows %u\n",
+               act.requests, act.merged, act.applied, act.overflows);
+        lvgl_port_pm_stats_t pm;
+        lvgl_port_get_pm_stats(&pm, true);
+        printf("CPU boost\t%u ms\tidle %u ms\tboosts %u\n", pm.boost_ms, pm.idle_ms, pm.boosts);
+        lvgl_port_refr_stats_t refr;
+        lvgl_port_get_refr_stats(&refr, true);
+        printf("Refresh active\t%u frames\t%u wakeups\t%u ms\tTE %u us\n",
+               refr.active.frames, refr.active.wakeups, refr.active.time_ms, refr.te_period_us);
+        printf("Refresh idle\t%u frames\t%u wakeups\t%u ms\n", refr.idle.frames, refr.idle.wakeups, refr.idle.time_ms);
+#if DMA_BLEND
+        lvgl_dma_stats_t dma;
+        lvgl_dma_get_stats(&dma, true);
+        printf("DMA fills %u\tcopies %u\t%u B by DMA\t%u B by CPU\twaits %u\n",
+               dma.fills, dma.copies, dma.dma_bytes, dma.cpu_bytes, dma.waits);
+#endif
+#if REDRAW_HEATMAP
+        print_heatmap();
+#endif
+
+#if COMPRESS_FB
+        lvgl_port_fbc_stats_t fbc;
+        lvgl_port_get_fbc_stats(&fbc);
+        printf("FBC tiles lossless/lossy\t%u/%u\trows %u\tencode %u us\tdecode %u us\n",
+               fbc.lossless_tiles, fbc.lossy_tiles, fbc.rows_sent, fbc.encode_us, fbc.decode_us);
+#endif
+
         printf("Getting real time stats over %d ticks\n", STATS_TICKS);
         if (print_real_time_stats(STATS_TICKS) == ESP_OK) {
             printf("Real time stats obtained\n");
@@ -177,6 +279,37 @@ static void sys_monitor_start(void)
 }
 #endif
 
+/**
+ * Device side of the state store, this is where the fan, lamp, amplifier and washer drivers
+ * would apply the values set on the knob. It never takes the LVGL lock.
+ */
+static void control_task(void *arg)
+{
+    static dev_state_sub_t sub;
+    static const char *const names[DEV_STATE_NUM] = {
+        [DEV_STATE_FAN_SPEED] = "fan speed",
+        [DEV_STATE_BRIGHTNESS] = "brightness",
+        [DEV_STATE_HUE] = "hue",
+        [DEV_STATE_VOLUME] = "volume",
+        [DEV_STATE_WASH_MODE] = "wash mode",
+    };
+
+    dev_state_subscribe(&sub, DEV_STATE_ALL, xTaskGetCurrentTaskHandle());
+    while (true) {
+        uint32_t changed;
+        xTaskNotifyWait(0, UINT32_MAX, &changed, portMAX_DELAY);
+        changed |= dev_state_take_changes(&sub);
+
+        dev_state_t state;
+        dev_state_read(&state);
+        for (int i = 0; i < DEV_STATE_NUM; i++) {
+            if (changed & DEV_STATE_BIT(i)) {
+                DLOG(&control_tag, "%s -> %d", names[i], state.v[i]);
+            }
+        }
+    }
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "Compile time: %s %s", __DATE__, __TIME__);
@@ -188,11 +321,34 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(err);
 
+    dlog_init(DLOG_BINARY);
+
+#ifdef CONFIG_PM_ENABLE
+    /**
+     * The LVGL port holds the max frequency while it renders. 80 MHz is the floor as the
+     * backlight LEDC and the SPI bus run from APB, which would drop below that.
+     */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_pm_config_t pm_config = {
+#else
+    esp_pm_config_esp32c3_t pm_config = {
+#endif
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 80,
+        .light_sleep_enable = false,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+#endif
+
     lvgl_port_config_t lvgl_config = {
         .display = {
             .width = LCD_H_RES,
             .height = LCD_V_RES,
+#if COMPRESS_FB
+            .buf_size = LCD_H_RES * 24,
+#else
             .buf_size = LCD_H_RES * LCD_V_RES,
+#endif
         },
         .tick_period = 2,
         .task = {
@@ -201,17 +357,59 @@ void app_main(void)
             .priority = 5,
         },
         .avoid_tear = true,
+        .compress_fb = COMPRESS_FB,
+        .lowres_anim = true,
+        .cpu_scaling = true,
+        .adaptive_refr = true,
+        .virtual_tick = VIRTUAL_TICK,
+        .dma_blend = DMA_BLEND,
+        .redraw_heatmap = REDRAW_HEATMAP,
     };
     lvgl_port(&lvgl_config);
+    ESP_LOGI(TAG, "internal heap after the frame buffers: %d B free, largest block %d B",
+             heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL),
+             heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
 
 #if MEMORY_MONITOR
     sys_monitor_start();
 #endif  
 
+    xTaskCreate(control_task, "Control Task", 3 * 1024, NULL, 3, NULL);
+
     lvgl_sem_take();
     ui_init();
     lvgl_sem_give();
 
     vTaskDelay(pdMS_TO_TICKS(100));
-    bsp_lcd_set_brightness(100);
+    lvgl_port_set_brightness(100);
+
+#if VIRTUAL_TICK
+    /**
+     * The same calls produce the same frames, so the frame cost of the intro animations can be
+     * compared exactly between builds. Afterwards this task keeps time at the real pace.
+     */
+    lvgl_port_frame_stats_t frame;
+    lvgl_port_get_frame_stats(&frame, true);
+    uint32_t elapsed = 0, next = 0;
+    while (elapsed < VIRTUAL_RUN_MS) {
+        uint32_t step = LV_CLAMP(1, next, VIRTUAL_RUN_MS - elapsed);
+        next = lvgl_port_advance(step);
+        elapsed += step;
+        /* let the idle task feed the watchdog, virtual time doesn't move meanwhile */
+        vTaskDelay(1);
+    }
+    lvgl_port_get_frame_stats(&frame, false);
+    ESP_LOGI(TAG, "virtual %u ms: %u frames, %u us rendering", elapsed, frame.frames, frame.total_us);
+    ui_census_t census;
+    lvgl_sem_take();
+    ui_census_take(ui_get_top_page(), &census);
+    lvgl_sem_give();
+    ui_census_print("page", &census);
+
+    while (true) {
+        next = LV_CLAMP(1, next, 500);
+        vTaskDelay(pdMS_TO_TICKS(next));
+        next = lvgl_port_advance(next);
+    }
+#endif
 }
@@ -0,0 +1,112 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "dev_state.h"
+
+#define DEV_STATE_MAX_SUBS  (4)
+
+static const char *TAG = "dev_state";
+
+/**
+ * Seqlock: `seq` is odd while a write is in progress and is bumped again when it's done.
+ * A reader that saw an odd or a changed seq around its copy retries.
+ */
+static uint32_t seq;
+static dev_state_t state = {
+    .v = {
+        [DEV_STATE_FAN_SPEED] = 30,
+        [DEV_STATE_BRIGHTNESS] = 30,
+        [DEV_STATE_HUE] = 0,
+        [DEV_STATE_VOLUME] = 18,
+        [DEV_STATE_WASH_MODE] = 0,
+    },
+};
+/* writers only; spinning on `seq` instead could starve a preempted writer on one core */
+static portMUX_TYPE write_lock = portMUX_INITIALIZER_UNLOCKED;
+static dev_state_sub_t *subs[DEV_STATE_MAX_SUBS];
+static uint8_t sub_cnt;
+
+void dev_state_read(dev_state_t *out)
+{
+    uint32_t s0, s1;
+
+    do {
+        s0 = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+        for (int i = 0; i < DEV_STATE_NUM; i++) {
+            out->v[i] = __atomic_load_n(&state.v[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        s1 = __atomic_load_n(&seq, __ATOMIC_RELAXED);
+    } while ((s0 & 1) || s0 != s1);
+}
+
+int16_t dev_state_get(dev_state_id_t id)
+{
+    /* a single aligned halfword can't be torn */
+    return __atomic_load_n(&state.v[id], __ATOMIC_RELAXED);
+}
+
+uint32_t dev_state_write(uint32_t mask, const dev_state_t *values)
+{
+    uint32_t changed = 0;
+
+    portENTER_CRITICAL(&write_lock);
+    for (int i = 0; i < DEV_STATE_NUM; i++) {
+        if ((mask & DEV_STATE_BIT(i)) && state.v[i] != values->v[i]) {
+            changed |= DEV_STATE_BIT(i);
+        }
+    }
+    if (changed) {
+        __atomic_store_n(&seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (int i = 0; i < DEV_STATE_NUM; i++) {
+            if (changed & DEV_STATE_BIT(i)) {
+                __atomic_store_n(&state.v[i], values->v[i], __ATOMIC_RELAXED);
+            }
+        }
+        __atomic_store_n(&seq, seq + 1, __ATOMIC_RELEASE);
+        for (uint8_t i = 0; i < sub_cnt; i++) {
+            __atomic_fetch_or(&subs[i]->pending, changed & subs[i]->mask, __ATOMIC_RELAXED);
+        }
+    }
+    portEXIT_CRITICAL(&write_lock);
+
+    /* the list only grows and entries stay valid, no need to hold the lock for it */
+    for (uint8_t i = 0; changed && i < sub_cnt; i++) {
+        if (subs[i]->task && (changed & subs[i]->mask)) {
+            xTaskNotify(subs[i]->task, changed & subs[i]->mask, eSetBits);
+        }
+    }
+    return changed;
+}
+
+bool dev_state_set(dev_state_id_t id, int16_t value)
+{
+    dev_state_t values;
+    values.v[id] = value;
+    return dev_state_write(DEV_STATE_BIT(id), &values) != 0;
+}
+
+void dev_state_subscribe(dev_state_sub_t *sub, uint32_t mask, TaskHandle_t task)
+{
+    sub->mask = mask;
+    sub->pending = 0;
+    sub->task = task;
+
+    portENTER_CRITICAL(&write_lock);
+    if (sub_cnt < DEV_STATE_MAX_SUBS) {
+        subs[sub_cnt] = sub;
+        __atomic_store_n(&sub_cnt, sub_cnt + 1, __ATOMIC_RELEASE);
+        sub = NULL;
+    }
+    portEXIT_CRITICAL(&write_lock);
+    if (sub) {
+        ESP_LOGE(TAG, "too many subscribers");
+    }
+}
+
+uint32_t dev_state_take_changes(dev_state_sub_t *sub)
+{
+    return __atomic_exchange_n(&sub->pending, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,73 @@
+#ifndef DEV_STATE_H
+#define DEV_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DEV_STATE_FAN_SPEED,        /* % */
+    DEV_STATE_BRIGHTNESS,       /* light, % */
+    DEV_STATE_HUE,              /* light colour, 0-359 degrees */
+    DEV_STATE_VOLUME,           /* player, 0-30 */
+    DEV_STATE_WASH_MODE,        /* washing programme index */
+    DEV_STATE_NUM,
+} dev_state_id_t;
+
+#define DEV_STATE_BIT(id)   (1u << (id))
+#define DEV_STATE_ALL       (DEV_STATE_BIT(DEV_STATE_NUM) - 1)
+
+typedef struct {
+    int16_t v[DEV_STATE_NUM];
+} dev_state_t;
+
+/**
+ * A reader of the changes in `mask`. `pending` collects the changed bits until they are taken;
+ * `task`, if set, also gets them as notification bits (eSetBits) on every change.
+ */
+typedef struct {
+    uint32_t mask;
+    uint32_t pending;
+    TaskHandle_t task;
+} dev_state_sub_t;
+
+/**
+ * Consistent snapshot of every value. Lock-free: the copy is retried while a write is in
+ * progress, so it never blocks a writer and is safe from any task.
+ */
+void dev_state_read(dev_state_t *state);
+
+int16_t dev_state_get(dev_state_id_t id);
+
+/**
+ * Write the values of `mask` from `values` as one update. Writers are serialised by a short
+ * critical section, readers never see a partial update.
+ * @return the bits of the values that actually changed
+ */
+uint32_t dev_state_write(uint32_t mask, const dev_state_t *values);
+
+/**
+ * @return true if the value changed
+ */
+bool dev_state_set(dev_state_id_t id, int16_t value);
+
+/**
+ * Register `sub` for the changes in `mask`. `sub` must stay valid, there is no unsubscribe.
+ */
+void dev_state_subscribe(dev_state_sub_t *sub, uint32_t mask, TaskHandle_t task);
+
+/**
+ * @return the bits changed since the last call, and clear them
+ */
+uint32_t dev_state_take_changes(dev_state_sub_t *sub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "dlog.h"
+
+#define DLOG_RING_SIZE      (64)    /* power of two */
+#define DLOG_TASK_PERIOD    (20)
+#define DLOG_TASK_PRIORITY  (1)
+
+typedef struct {
+    uint32_t seq;
+    uint32_t time_ms;
+    const char *fmt;
+    const dlog_tag_t *tag;
+    uint16_t suppressed;
+    uint8_t nargs;
+    uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+static const char *TAG = "dlog";
+
+/**
+ * Bounded MPMC queue: a slot is free for position `pos` while its seq equals pos and holds a
+ * record for it once seq is pos + 1. Producers only contend on `head` with a CAS.
+ */
+static dlog_record_t ring[DLOG_RING_SIZE];
+static uint32_t head;
+static uint32_t tail;
+static uint32_t dropped;
+static bool binary_out;
+static bool inited;
+
+static bool rate_limited(dlog_tag_t *tag, uint32_t now, uint16_t *suppressed)
+{
+    *suppressed = 0;
+    if (!tag || !tag->max_per_sec) {
+        return false;
+    }
+    if (now - tag->window_ms >= 1000) {
+        tag->window_ms = now;
+        tag->count = 0;
+    }
+    if (tag->count >= tag->max_per_sec) {
+        tag->suppressed++;
+        return true;
+    }
+    tag->count++;
+    *suppressed = tag->suppressed;
+    tag->suppressed = 0;
+    return false;
+}
+
+void dlog_write(dlog_tag_t *tag, const char *fmt, uint8_t nargs, ...)
+{
+    if (!inited) {
+        return;
+    }
+
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+    uint16_t suppressed;
+    if (rate_limited(tag, now, &suppressed)) {
+        return;
+    }
+
+    uint32_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    dlog_record_t *r;
+    for (;;) {
+        r = &ring[pos & (DLOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+
+    va_list ap;
+    va_start(ap, nargs);
+    nargs = nargs > DLOG_MAX_ARGS ? DLOG_MAX_ARGS : nargs;
+    for (int i = 0; i < nargs; i++) {
+        r->args[i] = va_arg(ap, uint32_t);
+    }
+    va_end(ap);
+    r->time_ms = now;
+    r->fmt = fmt;
+    r->tag = tag;
+    r->suppressed = suppressed;
+    r->nargs = nargs;
+    __atomic_store_n(&r->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t dlog_get_dropped(void)
+{
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+static void print_record(const dlog_record_t *r)
+{
+    const uint32_t *a = r->args;
+
+    if (binary_out) {
+        /* one line per record, tools/dlog_decode.py resolves the pointers with the ELF file */
+        printf("~D %08x %08x %08x %04x", r->time_ms, (uint32_t)r->fmt, (uint32_t)(r->tag ? r->tag->name : NULL),
+               r->suppressed);
+        for (int i = 0; i < r->nargs; i++) {
+            printf(" %08x", a[i]);
+        }
+        printf("\n");
+        return;
+    }
+
+    printf("[%u] %s: ", r->time_ms, r->tag ? r->tag->name : "-");
+    /* a literal from DLOG(), its arguments were checked there */
+    printf(r->fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+    if (r->suppressed) {
+        printf(" (+%u suppressed)", r->suppressed);
+    }
+    printf("\n");
+}
+
+static void dlog_task(void *arg)
+{
+    (void) arg;
+    uint32_t dropped_seen = 0;
+
+    while (true) {
+        for (;;) {
+            dlog_record_t *r = &ring[tail & (DLOG_RING_SIZE - 1)];
+            if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+                break;
+            }
+            dlog_record_t rec = *r;
+            __atomic_store_n(&r->seq, tail + DLOG_RING_SIZE, __ATOMIC_RELEASE);
+            tail++;
+            print_record(&rec);
+        }
+
+        uint32_t d = dlog_get_dropped();
+        if (d != dropped_seen) {
+            ESP_LOGW(TAG, "%u records dropped, ring full", d - dropped_seen);
+            dropped_seen = d;
+        }
+        vTaskDelay(pdMS_TO_TICKS(DLOG_TASK_PERIOD));
+    }
+}
+
+void dlog_init(bool binary)
+{
+    if (inited) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < DLOG_RING_SIZE; i++) {
+        ring[i].seq = i;
+    }
+    binary_out = binary;
+
+    BaseType_t ret = xTaskCreate(dlog_task, "dlog", 3 * 1024, NULL, DLOG_TASK_PRIORITY, NULL);
+    if (pdPASS != ret) {
+        ESP_LOGE(TAG, "create dlog task failed");
+        return;
+    }
+    inited = true;
+}
@@ -0,0 +1,56 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_MAX_ARGS   (6)
+
+/**
+ * A log source with its own rate limit. The state is updated by the callers without a lock,
+ * so under contention the limit is approximate.
+ */
+typedef struct {
+    const char *name;
+    uint16_t max_per_sec;   /* 0 for unlimited */
+    uint16_t count;
+    uint16_t suppressed;
+    uint32_t window_ms;
+} dlog_tag_t;
+
+#define DLOG_TAG_DEFINE(var, tag_name, rate) static dlog_tag_t var = {.name = (tag_name), .max_per_sec = (rate)}
+
+/**
+ * Start the low priority task that drains the ring buffer.
+ * @param binary print raw records for tools/dlog_decode.py instead of formatting on the device
+ */
+void dlog_init(bool binary);
+
+/**
+ * Record `fmt` and up to DLOG_MAX_ARGS 32-bit arguments, never blocks. The format string and
+ * any %s argument are stored as pointers, so they must stay valid (literals, const tables).
+ * Records are dropped when the ring buffer is full. Call it through DLOG().
+ */
+void dlog_write(dlog_tag_t *tag, const char *fmt, uint8_t nargs, ...) __attribute__((format(printf, 2, 4)));
+
+uint32_t dlog_get_dropped(void);
+
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+
+/**
+ * `fmt` must be a string literal: it is printed later by the log task as the format of
+ * printf(), and "" fmt doesn't compile for anything else. With -Wformat on, the arguments are
+ * checked against it like printf()'s.
+ */
+#define DLOG(tag, fmt, ...) dlog_write((tag), "" fmt, DLOG_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
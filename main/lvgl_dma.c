@@ -0,0 +1,185 @@
+#include <string.h>
+#include "lvgl_dma.h"
+#ifdef ESP_PLATFORM
+#include "soc/soc_caps.h"
+#endif
+
+#if defined(ESP_PLATFORM) && SOC_GDMA_SUPPORTED
+#define DMA_HW  1
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_idf_version.h"
+#include "esp_heap_caps.h"
+#include "esp_async_memcpy.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "esp_memory_utils.h"
+#else
+#include "soc/soc_memory_layout.h"
+#endif
+#else
+#define DMA_HW  0
+#endif
+
+#define FILL_BYTES  (4092)      /* pattern source of the fills: a multiple of 2, 3 and 4 px bytes, one descriptor */
+#define BACKLOG     (32)        /* a 240x240 RGB565 fill is 29 jobs */
+
+static lvgl_dma_stats_t stats;
+
+static void cpu_fill(uint8_t *dst, const void *px, uint8_t px_size, size_t count)
+{
+    if (px_size == 2) {
+        uint16_t v;
+        memcpy(&v, px, 2);
+        for (uint16_t *d = (uint16_t *)dst; count; count--) {
+            *d++ = v;
+        }
+        return;
+    }
+    for (; count; count--, dst += px_size) {
+        memcpy(dst, px, px_size);
+    }
+}
+
+#if DMA_HW
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+typedef async_memcpy_handle_t mcp_handle_t;
+#else
+typedef async_memcpy_t mcp_handle_t;
+#endif
+
+static mcp_handle_t mcp = NULL;
+static SemaphoreHandle_t idle_sem = NULL;
+static uint32_t pending = 0;
+static uint8_t *fill_buf = NULL;
+static uint32_t fill_px = 0;            /* pattern currently in fill_buf */
+static uint8_t fill_px_size = 0;
+
+static bool IRAM_ATTR done_cb(mcp_handle_t hdl, async_memcpy_event_t *event, void *args)
+{
+    BaseType_t need_yield = pdFALSE;
+    if (__atomic_sub_fetch(&pending, 1, __ATOMIC_RELAXED) == 0) {
+        xSemaphoreGiveFromISR(idle_sem, &need_yield);
+    }
+    return need_yield == pdTRUE;
+}
+
+static bool dma_reachable(const void *dst, const void *src, size_t len)
+{
+    /* flash mapped assets aren't, only the ones the asset pool copied to internal RAM */
+    return mcp && len >= LVGL_DMA_MIN_BYTES && !(((uintptr_t)dst | (uintptr_t)src | len) & 3)
+           && esp_ptr_dma_capable(dst) && esp_ptr_dma_capable(src);
+}
+
+/* the descriptors run in order, so a job may overlap the ones queued before it */
+static bool dma_submit(void *dst, const void *src, size_t len)
+{
+    __atomic_add_fetch(&pending, 1, __ATOMIC_RELAXED);
+    if (esp_async_memcpy(mcp, dst, (void *)src, len, done_cb, NULL) != ESP_OK) {
+        __atomic_sub_fetch(&pending, 1, __ATOMIC_RELAXED);
+        /* backlog full, retry once it drained */
+        lvgl_dma_wait();
+        __atomic_add_fetch(&pending, 1, __ATOMIC_RELAXED);
+        if (esp_async_memcpy(mcp, dst, (void *)src, len, done_cb, NULL) != ESP_OK) {
+            __atomic_sub_fetch(&pending, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+    stats.dma_bytes += len;
+    return true;
+}
+#endif
+
+bool lvgl_dma_init(void)
+{
+#if DMA_HW
+    async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    config.backlog = BACKLOG;
+    idle_sem = xSemaphoreCreateBinary();
+    fill_buf = (uint8_t *)heap_caps_malloc(FILL_BYTES, MALLOC_CAP_DMA);
+    if (idle_sem && fill_buf && esp_async_memcpy_install(&config, &mcp) == ESP_OK) {
+        return true;
+    }
+    mcp = NULL;
+#endif
+    return false;
+}
+
+void lvgl_dma_copy(void *dst, const void *src, size_t len)
+{
+    stats.copies++;
+#if DMA_HW
+    if (dma_reachable(dst, src, len) && dma_submit(dst, src, len)) {
+        return;
+    }
+    /* queued jobs may still write to the same bytes */
+    lvgl_dma_wait();
+#endif
+    memcpy(dst, src, len);
+    stats.cpu_bytes += len;
+}
+
+void lvgl_dma_fill(void *dst, const void *px, uint8_t px_size, size_t count)
+{
+    stats.fills++;
+    uint8_t *d = (uint8_t *)dst;
+#if DMA_HW
+    size_t len = count * px_size;
+    if (FILL_BYTES % px_size == 0 && dma_reachable(d, fill_buf, len)) {
+        uint32_t v = 0;
+        memcpy(&v, px, px_size);
+        if (v != fill_px || px_size != fill_px_size) {
+            /* the queued fills still read the old pattern */
+            lvgl_dma_wait();
+            cpu_fill(fill_buf, px, px_size, FILL_BYTES / px_size);
+            fill_px = v;
+            fill_px_size = px_size;
+        }
+        while (len) {
+            size_t n = len < FILL_BYTES ? len : FILL_BYTES;
+            if (!dma_submit(d, fill_buf, n)) {
+                break;
+            }
+            d += n;
+            len -= n;
+        }
+        if (!len) {
+            return;
+        }
+        count = len / px_size;
+    }
+    lvgl_dma_wait();
+#endif
+    cpu_fill(d, px, px_size, count);
+    stats.cpu_bytes += count * px_size;
+}
+
+void lvgl_dma_wait(void)
+{
+#if DMA_HW
+    if (__atomic_load_n(&pending, __ATOMIC_RELAXED)) {
+        stats.waits++;
+        /* a give left over from an earlier drain only costs another loop */
+        while (__atomic_load_n(&pending, __ATOMIC_RELAXED)) {
+            xSemaphoreTake(idle_sem, portMAX_DELAY);
+        }
+    }
+#endif
+}
+
+bool lvgl_dma_busy(void)
+{
+#if DMA_HW
+    return __atomic_load_n(&pending, __ATOMIC_RELAXED) != 0;
+#else
+    return false;
+#endif
+}
+
+void lvgl_dma_get_stats(lvgl_dma_stats_t *out, bool reset)
+{
+    *out = stats;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+    }
+}
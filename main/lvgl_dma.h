@@ -0,0 +1,54 @@
+#ifndef LVGL_DMA_H
+#define LVGL_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Memory to memory copies and fills for the draw buffer. On chips with GDMA they are queued
+ * to the async memcpy driver and run while the CPU goes on; elsewhere, and for buffers the
+ * DMA can't reach, the same calls run on the CPU before they return.
+ */
+#define LVGL_DMA_MIN_BYTES  (2048)      /* smaller jobs are cheaper on the CPU than a descriptor */
+
+typedef struct {
+    uint32_t copies;
+    uint32_t fills;
+    uint32_t dma_bytes;
+    uint32_t cpu_bytes;     /* too small, unaligned, not DMA capable or no DMA at all */
+    uint32_t waits;         /* lvgl_dma_wait() calls that found transfers in flight */
+} lvgl_dma_stats_t;
+
+/**
+ * @return false if there is no M2M DMA, all jobs then run on the CPU
+ */
+bool lvgl_dma_init(void);
+
+/**
+ * Copy `len` bytes, `dst` and `src` must not be touched until lvgl_dma_wait().
+ */
+void lvgl_dma_copy(void *dst, const void *src, size_t len);
+
+/**
+ * Write `count` copies of the `px_size` byte pattern `px` (up to 4 bytes) to `dst`.
+ */
+void lvgl_dma_fill(void *dst, const void *px, uint8_t px_size, size_t count);
+
+/**
+ * Block until all queued jobs are done.
+ */
+void lvgl_dma_wait(void);
+bool lvgl_dma_busy(void);
+
+void lvgl_dma_get_stats(lvgl_dma_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+#include <string.h>
+#include "lvgl.h"
+#include "lvgl_fbc.h"
+
+#define MODE_PALETTE        (0x00)
+#define MODE_INTERP         (0x80)
+#define HALF_PIXELS         (FBC_TILE_PIXELS / 2)
+#define INTERP_LEVELS       (8)
+
+/* Pixels are kept in lv_color_t byte order, only the lossy path needs the components */
+static inline uint16_t to_rgb565(uint16_t raw)
+{
+#if LV_COLOR_16_SWAP
+    return (raw >> 8) | (raw << 8);
+#else
+    return raw;
+#endif
+}
+
+static inline uint16_t from_rgb565(uint16_t v)
+{
+    return to_rgb565(v);
+}
+
+static bool encode_palette(const uint16_t *px, uint8_t *slot)
+{
+    uint16_t pal[4];
+    uint8_t n = 0;
+    uint32_t idx = 0;
+
+    for (int i = 0; i < FBC_TILE_PIXELS; i++) {
+        uint8_t k = 0;
+        while (k < n && pal[k] != px[i]) {
+            k++;
+        }
+        if (k == n) {
+            if (n == 4) {
+                return false;
+            }
+            pal[n++] = px[i];
+        }
+        idx |= (uint32_t)k << (i * 2);
+    }
+
+    slot[0] = MODE_PALETTE | (n - 1);
+    memcpy(&slot[1], pal, n * sizeof(uint16_t));
+    memcpy(&slot[9], &idx, sizeof(idx));
+    return true;
+}
+
+static void encode_half(const uint16_t *px, uint8_t *out)
+{
+    int r[HALF_PIXELS], g[HALF_PIXELS], b[HALF_PIXELS];
+    int lo = 0, hi = 0, lo_l = INT32_MAX, hi_l = -1;
+
+    /* endpoints: darkest and brightest pixel, weighted to a common 6 bit scale */
+    for (int i = 0; i < HALF_PIXELS; i++) {
+        uint16_t v = to_rgb565(px[i]);
+        r[i] = v >> 11;
+        g[i] = (v >> 5) & 0x3f;
+        b[i] = v & 0x1f;
+        int l = (r[i] << 1) + g[i] + (b[i] << 1);
+        if (l < lo_l) {
+            lo_l = l;
+            lo = i;
+        }
+        if (l > hi_l) {
+            hi_l = l;
+            hi = i;
+        }
+    }
+
+    int dr = r[hi] - r[lo], dg = g[hi] - g[lo], db = b[hi] - b[lo];
+    int len2 = dr * dr * 4 + dg * dg + db * db * 4;
+    uint32_t idx = 0;
+    for (int i = 0; i < HALF_PIXELS; i++) {
+        int t = 0;
+        if (len2) {
+            int dot = (r[i] - r[lo]) * dr * 4 + (g[i] - g[lo]) * dg + (b[i] - b[lo]) * db * 4;
+            t = (dot * (INTERP_LEVELS - 1) + len2 / 2) / len2;
+            t = LV_CLAMP(0, t, INTERP_LEVELS - 1);
+        }
+        idx |= (uint32_t)t << (i * 3);
+    }
+
+    uint16_t ends[2] = {px[lo], px[hi]};
+    memcpy(out, ends, sizeof(ends));
+    out[4] = idx;
+    out[5] = idx >> 8;
+    out[6] = idx >> 16;
+}
+
+bool fbc_encode_tile(const uint16_t *px, uint8_t *slot)
+{
+    if (encode_palette(px, slot)) {
+        return true;
+    }
+    slot[0] = MODE_INTERP;
+    encode_half(px, &slot[1]);
+    encode_half(px + HALF_PIXELS, &slot[8]);
+    return false;
+}
+
+static void decode_half(const uint8_t *in, uint16_t *px)
+{
+    uint16_t ends[2];
+    memcpy(ends, in, sizeof(ends));
+    uint16_t a = to_rgb565(ends[0]), b = to_rgb565(ends[1]);
+    int ar = a >> 11, ag = (a >> 5) & 0x3f, ab = a & 0x1f;
+    int dr = (b >> 11) - ar, dg = ((b >> 5) & 0x3f) - ag, db = (b & 0x1f) - ab;
+
+    uint16_t levels[INTERP_LEVELS];
+    for (int t = 0; t < INTERP_LEVELS; t++) {
+        int r = ar + (dr * t + (INTERP_LEVELS - 1) / 2) / (INTERP_LEVELS - 1);
+        int g = ag + (dg * t + (INTERP_LEVELS - 1) / 2) / (INTERP_LEVELS - 1);
+        int bl = ab + (db * t + (INTERP_LEVELS - 1) / 2) / (INTERP_LEVELS - 1);
+        levels[t] = from_rgb565((r << 11) | (g << 5) | bl);
+    }
+    levels[0] = ends[0];
+    levels[INTERP_LEVELS - 1] = ends[1];
+
+    uint32_t idx = in[4] | (in[5] << 8) | ((uint32_t)in[6] << 16);
+    for (int i = 0; i < HALF_PIXELS; i++) {
+        px[i] = levels[(idx >> (i * 3)) & 0x7];
+    }
+}
+
+void fbc_decode_tile(const uint8_t *slot, uint16_t *px)
+{
+    if (slot[0] & MODE_INTERP) {
+        decode_half(&slot[1], px);
+        decode_half(&slot[8], px + HALF_PIXELS);
+        return;
+    }
+
+    uint16_t pal[4];
+    uint32_t idx;
+    memcpy(pal, &slot[1], sizeof(pal));
+    memcpy(&idx, &slot[9], sizeof(idx));
+    for (int i = 0; i < FBC_TILE_PIXELS; i++) {
+        px[i] = pal[(idx >> (i * 2)) & 0x3];
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef LVGL_FBC_H
+#define LVGL_FBC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Fixed-rate frame buffer compression: every run of 16 horizontal RGB565 pixels (32 bytes)
+ * is stored in a 16 byte slot, so any tile can be rewritten in place.
+ * Tiles with up to 4 distinct colours are stored losslessly as a palette, others as two
+ * 8 pixel halves with 2 endpoints and 8 interpolated levels each.
+ */
+#define FBC_TILE_PIXELS     (16)
+#define FBC_TILE_BYTES      (16)
+
+static inline uint32_t fbc_store_size(uint16_t width, uint16_t height)
+{
+    return (uint32_t)width * height / FBC_TILE_PIXELS * FBC_TILE_BYTES;
+}
+
+/**
+ * @return true if the tile was stored losslessly
+ */
+bool fbc_encode_tile(const uint16_t *px, uint8_t *slot);
+void fbc_decode_tile(const uint8_t *slot, uint16_t *px);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,18 +5,84 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#ifdef CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 
 #include "lvgl.h"
 #include "bsp_lcd.h"
 #include "bsp_indev.h"
 #include "lvgl_port.h"
+#include "lvgl_fbc.h"
+#include "lvgl_dma.h"
+
+#define STRIPE_LINES        (16)
+#define PM_INPUT_HOLD_MS    (1000)
+#define REFR_INPUT_HOLD_MS  (500)
+#define REFR_FAST_PERIOD    (16)    /* until the TE period is known */
+#define REFR_MAX_SLEEP      (500)
+#define HEATMAP_OPA         (LV_OPA_40)
+
+typedef void (*stripe_fill_cb_t)(uint16_t *dst, const lv_area_t *area, int y, int lines, const void *src);
 
 static char *TAG = "lvgl_port";
 static lv_disp_drv_t disp_drv;
 static lv_indev_drv_t indev_drv;
 static TaskHandle_t task = NULL;
 static SemaphoreHandle_t sem_lock = NULL;
+static esp_timer_handle_t tick_timer = NULL;
+static uint8_t tick_period = 0;
+static int32_t encoder_last = 0;
+static bool display_off = false;
+static bool tick_virtual = false;
+static int64_t render_start_us = 0;
+static int64_t flush_wait_us = 0;
+
+static uint16_t *stripe_buf[2];
+static SemaphoreHandle_t stripe_free = NULL;
+static uint8_t stripe_index = 0;
+static bool stripe_avoid_tear = false;
+
+static uint8_t *fbc_store = NULL;
+static lv_area_t fbc_dirty = {0, 0, -1, -1};
+static lvgl_port_fbc_stats_t fbc_frame;
+static lvgl_port_fbc_stats_t fbc_stats;
+
+#if LV_COLOR_DEPTH == 8
+static uint16_t lut_rgb332[256];
+#endif
+
+static lvgl_port_frame_stats_t frame_stats;
+static uint32_t frame_count = 0;
+static lvgl_port_frame_cb_t frame_cb = NULL;
+
+static bool lowres_enabled = false;
+static bool lowres_frame = false;
+static uint16_t lowres_holds = 0;
 
+static bool dma_enabled = false;
+static lv_area_t dma_area = {0, 0, -1, -1};    /* written by the queued DMA jobs */
+static void *dma_buf = NULL;                    /* the buffer dma_area is in */
+
+#ifdef CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t pm_lock = NULL;
+#endif
+static bool pm_boost = false;
+static int64_t pm_since = 0;
+static lvgl_port_pm_stats_t pm_stats;
+
+static bool refr_adaptive = false;
+static bool refr_active = true;
+static int64_t refr_since = 0;
+static lvgl_port_refr_stats_t refr_stats;
+
+static uint16_t *heat_counts = NULL;
+static lv_color_t *heat_tint = NULL;
+static uint16_t heat_cols = 0;
+static uint16_t heat_rows = 0;
+static uint32_t heat_frames = 0;
+
+static void pm_init(lvgl_port_config_t *config);
 static void display_init(lvgl_port_config_t *config);
 static void tick_init(uint8_t period);
 static void lvgl_task(void *arg);
@@ -32,18 +98,21 @@ void lvgl_sem_give(void)
 {
     if (xTaskGetCurrentTaskHandle() != task) {
         xSemaphoreGive(sem_lock);
+        /* the caller may have changed the UI while the task sleeps on demand */
+        if (task) {
+            xTaskNotifyGive(task);
+        }
     }
 }
 
 static void encoder_read(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
 {
-    static int32_t last_v = 0;
     static int32_t invd = 0;
 
     invd = bsp_encoder_get_value();
-    data->enc_diff = last_v - invd;
+    data->enc_diff = encoder_last - invd;
     data->state = (bsp_btn_get_state(BSP_BTN_PIN_NUM) == 0) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
-    last_v = invd;
+    encoder_last = invd;
 }
 
 static void indev_init(void)
@@ -61,12 +130,22 @@ static void indev_init(void)
 void lvgl_port(lvgl_port_config_t *config)
 {
     lv_init();
+    tick_virtual = config->virtual_tick;
+    /* the harness drives time, a changing CPU clock or TE rate would only add noise */
+    refr_adaptive = config->adaptive_refr && !tick_virtual;
+    refr_since = esp_timer_get_time();
+    pm_init(config);
     display_init(config);
     indev_init();
     tick_init(config->tick_period);
 
     sem_lock = xSemaphoreCreateBinary();
     xSemaphoreGive(sem_lock);
+    if (tick_virtual) {
+        /* pm_update() never runs, a cpu_scaling boost taken by pm_init() is kept */
+        ESP_LOGI(TAG, "Finish init, virtual time");
+        return;
+    }
     xTaskCreatePinnedToCore(
         lvgl_task, "lvgl", 4096, (void *)config->task.period, config->task.priority,
         &task, config->task.core_id
@@ -74,10 +153,469 @@ void lvgl_port(lvgl_port_config_t *config)
     ESP_LOGI(TAG, "Finish init");
 }
 
+static void monitor_cb(struct _lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    /* the waits for the panel aren't rendering, they'd put every frame at the TE period */
+    uint32_t us = esp_timer_get_time() - render_start_us - flush_wait_us;
+    if (tick_virtual) {
+        /* LVGL time stands still while rendering */
+        time = us / 1000;
+    }
+    frame_stats.last_us = us;
+    frame_stats.total_us += us;
+    heat_frames++;
+    frame_count++;
+    frame_stats.frames++;
+    frame_stats.last_ms = time;
+    frame_stats.last_px = px;
+    frame_stats.max_ms = LV_MAX(frame_stats.max_ms, time);
+    frame_stats.avg_ms = (frame_stats.frames == 1) ? time : (frame_stats.avg_ms * 15 + time) / 16;
+    if (refr_active) {
+        refr_stats.active.frames++;
+    } else {
+        refr_stats.idle.frames++;
+    }
+    if (frame_cb) {
+        frame_cb(us, px);
+    }
+}
+
+void lvgl_port_set_frame_cb(lvgl_port_frame_cb_t cb)
+{
+    frame_cb = cb;
+}
+
+void lvgl_port_get_frame_stats(lvgl_port_frame_stats_t *stats, bool reset)
+{
+    lvgl_sem_take();
+    *stats = frame_stats;
+    if (reset) {
+        lv_memset_00(&frame_stats, sizeof(frame_stats));
+    }
+    lvgl_sem_give();
+}
+
+uint32_t lvgl_port_get_frame_count(void)
+{
+    return frame_count;
+}
+
+static void pm_set_boost(bool boost)
+{
+#ifdef CONFIG_PM_ENABLE
+    if (!pm_lock || boost == pm_boost) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    uint32_t ms = (now - pm_since) / 1000;
+    if (boost) {
+        esp_pm_lock_acquire(pm_lock);
+        pm_stats.idle_ms += ms;
+        pm_stats.boosts++;
+    } else {
+        esp_pm_lock_release(pm_lock);
+        pm_stats.boost_ms += ms;
+    }
+    pm_since = now;
+    pm_boost = boost;
+#endif
+}
+
+static void pm_init(lvgl_port_config_t *config)
+{
+#ifdef CONFIG_PM_ENABLE
+    if (config->cpu_scaling) {
+        ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lvgl", &pm_lock));
+        pm_since = esp_timer_get_time();
+        /* boosted until the first idle check, the boot screen is drawn at full speed */
+        pm_set_boost(true);
+    }
+#else
+    if (config->cpu_scaling) {
+        ESP_LOGW(TAG, "cpu scaling needs CONFIG_PM_ENABLE");
+    }
+#endif
+}
+
+/**
+ * A frame is about to be drawn, it gets the max frequency. The lock is taken here and not
+ * when an area is invalidated, so a timer that moves a needle once per second costs one
+ * boosted frame.
+ */
+static void render_start_cb(struct _lv_disp_drv_t *drv)
+{
+    render_start_us = esp_timer_get_time();
+    flush_wait_us = 0;
+    pm_set_boost(true);
+}
+
+/**
+ * Called after lv_timer_handler(): stay boosted while animations run, input was seen recently,
+ * more areas wait for the next frame or the last flush is still on the bus.
+ */
+static void pm_update(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    bool busy = lv_anim_count_running() || disp->inv_p || disp_drv.draw_buf->flushing
+                || lv_disp_get_inactive_time(disp) < PM_INPUT_HOLD_MS;
+    pm_set_boost(busy);
+}
+
+void lvgl_port_get_pm_stats(lvgl_port_pm_stats_t *stats, bool reset)
+{
+    lvgl_sem_take();
+    /* account the running period up to now */
+    if (pm_since) {
+        int64_t now = esp_timer_get_time();
+        uint32_t ms = (now - pm_since) / 1000;
+        if (pm_boost) {
+            pm_stats.boost_ms += ms;
+        } else {
+            pm_stats.idle_ms += ms;
+        }
+        pm_since = now;
+    }
+    *stats = pm_stats;
+    if (reset) {
+        lv_memset_00(&pm_stats, sizeof(pm_stats));
+    }
+    lvgl_sem_give();
+}
+
+static void refr_account(int64_t now)
+{
+    uint32_t ms = (now - refr_since) / 1000;
+    if (refr_active) {
+        refr_stats.active.time_ms += ms;
+    } else {
+        refr_stats.idle.time_ms += ms;
+    }
+    refr_since = now;
+}
+
+/**
+ * Pick the refresh period for the next frames. While something moves the refresh and the
+ * animation timer run at the panel's TE period, more frames than that can't be shown. A static scene pauses the
+ * timer and only wakes it for a frame when an area has been invalidated.
+ * @return the longest the LVGL task may sleep before the refresh timer is due
+ */
+static uint32_t refr_update(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    bool active = lv_anim_count_running() || lv_disp_get_inactive_time(disp) < REFR_INPUT_HOLD_MS;
+
+    if (active != refr_active) {
+        refr_account(esp_timer_get_time());
+        refr_active = active;
+    }
+
+    if (active) {
+        uint32_t te_us = bsp_lcd_get_te_period_us();
+        uint32_t period = te_us ? (te_us + 999) / 1000 : REFR_FAST_PERIOD;
+        refr_stats.te_period_us = te_us;
+        lv_timer_set_period(disp->refr_timer, period);
+        lv_timer_resume(disp->refr_timer);
+        /* otherwise the extra frames show the same animation state */
+        lv_timer_set_period(lv_anim_get_timer(), period);
+        return period;
+    }
+    lv_timer_set_period(lv_anim_get_timer(), LV_DISP_DEF_REFR_PERIOD);
+    if (disp->inv_p || disp->act_scr->layout_inv || disp->act_scr->scr_layout_inv) {
+        lv_timer_resume(disp->refr_timer);
+        lv_timer_ready(disp->refr_timer);
+        return 0;
+    }
+    lv_timer_pause(disp->refr_timer);
+    return REFR_MAX_SLEEP;
+}
+
+void lvgl_port_get_refr_stats(lvgl_port_refr_stats_t *stats, bool reset)
+{
+    lvgl_sem_take();
+    refr_account(esp_timer_get_time());
+    *stats = refr_stats;
+    if (reset) {
+        lv_memset_00(&refr_stats, sizeof(refr_stats));
+    }
+    lvgl_sem_give();
+}
+
+void lvgl_port_lowres_hold(void)
+{
+    lowres_holds++;
+}
+
+void lvgl_port_lowres_release(void)
+{
+    if (lowres_holds) {
+        lowres_holds--;
+    }
+}
+
+/**
+ * Latch the render resolution between two lv_timer_handler() calls, the whole frame is drawn
+ * at one resolution. The first frame after the last hold is released redraws everything sharp.
+ */
+static void lowres_update(void)
+{
+    bool was_lowres = lowres_frame;
+    lowres_frame = lowres_enabled && lowres_holds;
+    if (was_lowres && !lowres_frame) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+}
+
+/**
+ * Snapshots and layers get a draw context of this driver too, but draw into their own buffer,
+ * maybe with alpha through set_px_cb. Only the display's draw buffer is flushed by the port.
+ */
+static bool blend_to_disp(const lv_draw_ctx_t *draw_ctx)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    return disp && disp->driver == &disp_drv && !disp->driver->set_px_cb
+           && draw_ctx->buf == disp_drv.draw_buf->buf_act;
+}
+
+/**
+ * Low resolution blend: only the even rows and columns of the 2x2 blocks are blended,
+ * nearest-neighbour upscaling fills the rest at flush time.
+ */
+static void lowres_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    if (!lowres_frame || dsc->blend_mode != LV_BLEND_MODE_NORMAL || !blend_to_disp(draw_ctx)) {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        return;
+    }
+    if (dsc->opa <= LV_OPA_MIN || dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) {
+        return;
+    }
+
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return;
+    }
+
+    const lv_opa_t *mask = (dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) ? NULL : dsc->mask_buf;
+    lv_coord_t buf_w = lv_area_get_width(draw_ctx->buf_area);
+    lv_coord_t src_w = lv_area_get_width(dsc->blend_area);
+    lv_coord_t mask_w = mask ? lv_area_get_width(dsc->mask_area) : 0;
+    lv_coord_t x_start = (area.x1 + 1) & ~1;
+
+    for (lv_coord_t y = (area.y1 + 1) & ~1; y <= area.y2; y += 2) {
+        lv_color_t *dst = (lv_color_t *)draw_ctx->buf + (y - draw_ctx->buf_area->y1) * buf_w - draw_ctx->buf_area->x1;
+        const lv_color_t *src = dsc->src_buf ? dsc->src_buf + (y - dsc->blend_area->y1) * src_w - dsc->blend_area->x1 : NULL;
+        const lv_opa_t *m = mask ? mask + (y - dsc->mask_area->y1) * mask_w - dsc->mask_area->x1 : NULL;
+        for (lv_coord_t x = x_start; x <= area.x2; x += 2) {
+            lv_opa_t opa = dsc->opa;
+            if (m) {
+                opa = (m[x] >= LV_OPA_MAX) ? opa : (lv_opa_t)((opa * m[x]) >> 8);
+            }
+            if (opa <= LV_OPA_MIN) {
+                continue;
+            }
+            lv_color_t c = src ? src[x] : dsc->color;
+            dst[x] = (opa >= LV_OPA_MAX) ? c : lv_color_mix(c, dst[x], opa);
+        }
+    }
+}
+
+/**
+ * Opaque, unmasked fills and copies that cover whole rows of the draw buffer are contiguous in
+ * memory and go to the DMA. The page backgrounds and the full screen images of the apps do.
+ * @return false if the CPU has to blend it
+ */
+static bool dma_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    if (dsc->blend_mode != LV_BLEND_MODE_NORMAL || dsc->opa < LV_OPA_MAX
+            || (dsc->mask_buf && dsc->mask_res != LV_DRAW_MASK_RES_FULL_COVER)) {
+        return false;
+    }
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return true;
+    }
+    const lv_area_t *buf_area = draw_ctx->buf_area;
+    if (area.x1 != buf_area->x1 || area.x2 != buf_area->x2) {
+        return false;
+    }
+    lv_coord_t w = lv_area_get_width(&area);
+    uint32_t px = w * lv_area_get_height(&area);
+    if (px * sizeof(lv_color_t) < LVGL_DMA_MIN_BYTES) {
+        return false;
+    }
+    lv_color_t *dst = (lv_color_t *)draw_ctx->buf + (area.y1 - buf_area->y1) * w;
+    if (dsc->src_buf) {
+        /* the source rows are only contiguous if the image isn't clipped left or right */
+        if (lv_area_get_width(dsc->blend_area) != w) {
+            return false;
+        }
+        lvgl_dma_copy(dst, dsc->src_buf + (area.y1 - dsc->blend_area->y1) * w, px * sizeof(lv_color_t));
+    } else {
+        lvgl_dma_fill(dst, &dsc->color, sizeof(lv_color_t), px);
+    }
+    if (dma_area.x2 < dma_area.x1) {
+        dma_area = area;
+    } else {
+        _lv_area_join(&dma_area, &dma_area, &area);
+    }
+    return true;
+}
+
+/* the CPU may only touch what the queued jobs don't write */
+static void dma_sync(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    lv_area_t area;
+    if (dma_area.x2 < dma_area.x1 || !_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return;
+    }
+    if (!lvgl_dma_busy()) {
+        lv_area_set(&dma_area, 0, 0, -1, -1);
+    } else if (_lv_area_is_on(&area, &dma_area)) {
+        lvgl_dma_wait();
+        lv_area_set(&dma_area, 0, 0, -1, -1);
+    }
+}
+
+static void port_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    if (dma_enabled) {
+        if (draw_ctx->buf != dma_buf) {
+            /* a snapshot or a layer starts or ends, dma_area says nothing about the new buffer */
+            lvgl_dma_wait();
+            lv_area_set(&dma_area, 0, 0, -1, -1);
+            dma_buf = draw_ctx->buf;
+        }
+        if (!lowres_frame && blend_to_disp(draw_ctx) && dma_blend(draw_ctx, dsc)) {
+            return;
+        }
+        dma_sync(draw_ctx, dsc);
+    }
+    lowres_blend(draw_ctx, dsc);
+}
+
+/* LVGL calls this before the buffer is flushed */
+static void port_wait_for_finish(lv_draw_ctx_t *draw_ctx)
+{
+    lvgl_dma_wait();
+    lv_area_set(&dma_area, 0, 0, -1, -1);
+    lv_draw_sw_wait_for_finish(draw_ctx);
+}
+
+static void port_draw_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+    ((lv_draw_sw_ctx_t *)draw_ctx)->blend = port_blend;
+    if (dma_enabled) {
+        draw_ctx->wait_for_finish = port_wait_for_finish;
+    }
+}
+
+/* areas are rounded to whole 2x2 blocks, so row and column 0 of `buf` are always even */
+static void lowres_upscale(lv_color_t *buf, const lv_area_t *area)
+{
+    if (!lowres_frame) {
+        return;
+    }
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t h = lv_area_get_height(area);
+    for (lv_coord_t y = 0; y + 1 < h; y += 2) {
+        lv_color_t *row = buf + y * w;
+        for (lv_coord_t x = 0; x + 1 < w; x += 2) {
+            row[x + 1] = row[x];
+        }
+        lv_memcpy(row + w, row, w * sizeof(lv_color_t));
+    }
+}
+
+static void heatmap_init(lvgl_port_config_t *config)
+{
+    heat_cols = (config->display.width + LVGL_PORT_HEATMAP_TILE - 1) / LVGL_PORT_HEATMAP_TILE;
+    heat_rows = (config->display.height + LVGL_PORT_HEATMAP_TILE - 1) / LVGL_PORT_HEATMAP_TILE;
+    heat_counts = (uint16_t *)heap_caps_calloc(heat_cols * heat_rows, sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    heat_tint = (lv_color_t *)heap_caps_malloc(heat_cols * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    assert(heat_counts && heat_tint);
+}
+
+/* blue for a tile drawn once, through green and yellow to red for 128 redraws and more */
+static lv_color_t heatmap_color(uint16_t count)
+{
+    static const lv_palette_t ramp[] = {
+        LV_PALETTE_BLUE, LV_PALETTE_CYAN, LV_PALETTE_GREEN, LV_PALETTE_LIME,
+        LV_PALETTE_YELLOW, LV_PALETTE_AMBER, LV_PALETTE_ORANGE, LV_PALETTE_RED,
+    };
+    uint8_t level = 0;
+    while (count > 1 && level < sizeof(ramp) / sizeof(ramp[0]) - 1) {
+        count >>= 1;
+        level++;
+    }
+    return lv_palette_main(ramp[level]);
+}
+
+/**
+ * Count `area` for every tile it touches and tint it with the colour of the new counts. Areas
+ * that aren't redrawn keep their last tint, so a static screen shows where it was drawn last.
+ */
+static void heatmap_mark(lv_color_t *buf, const lv_area_t *area)
+{
+    if (!heat_counts) {
+        return;
+    }
+    uint16_t tx1 = area->x1 / LVGL_PORT_HEATMAP_TILE;
+    uint16_t tx2 = area->x2 / LVGL_PORT_HEATMAP_TILE;
+    lv_coord_t w = lv_area_get_width(area);
+    for (uint16_t ty = area->y1 / LVGL_PORT_HEATMAP_TILE; ty <= area->y2 / LVGL_PORT_HEATMAP_TILE; ty++) {
+        for (uint16_t tx = tx1; tx <= tx2; tx++) {
+            uint16_t *count = &heat_counts[ty * heat_cols + tx];
+            if (*count < UINT16_MAX) {
+                (*count)++;
+            }
+            heat_tint[tx] = heatmap_color(*count);
+        }
+        lv_coord_t y1 = LV_MAX(area->y1, ty * LVGL_PORT_HEATMAP_TILE);
+        lv_coord_t y2 = LV_MIN(area->y2, (ty + 1) * LVGL_PORT_HEATMAP_TILE - 1);
+        for (lv_coord_t y = y1; y <= y2; y++) {
+            lv_color_t *row = buf + (y - area->y1) * w - area->x1;
+            for (lv_coord_t x = area->x1; x <= area->x2; x++) {
+                row[x] = lv_color_mix(heat_tint[x / LVGL_PORT_HEATMAP_TILE], row[x], HEATMAP_OPA);
+            }
+        }
+    }
+}
+
+uint32_t lvgl_port_get_heatmap(uint16_t *counts, bool reset)
+{
+    lvgl_sem_take();
+    uint32_t frames = 0;
+    if (heat_counts) {
+        lv_memcpy(counts, heat_counts, heat_cols * heat_rows * sizeof(uint16_t));
+        frames = heat_frames;
+        if (reset) {
+            lv_memset_00(heat_counts, heat_cols * heat_rows * sizeof(uint16_t));
+            heat_frames = 0;
+        }
+    }
+    lvgl_sem_give();
+    return frames;
+}
+
+/**
+ * Wait for the panel (the previous transfer, or TE when tearing is avoided) and keep the time
+ * out of the frame's render time.
+ */
+static void flush_wait(void)
+{
+    int64_t t0 = esp_timer_get_time();
+    bsp_lcd_wait_flush_ready();
+    flush_wait_us += esp_timer_get_time() - t0;
+}
+
+#if LV_COLOR_DEPTH != 8
 static void flush_cb(struct _lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
 {
-    if (drv->full_refresh) {
-        bsp_lcd_wait_flush_ready();
+    lowres_upscale(color_p, area);
+    heatmap_mark(color_p, area);
+    if (drv->full_refresh && !tick_virtual) {
+        flush_wait();
     }
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
     int offsetx1 = area->x1;
@@ -93,25 +631,294 @@ static bool trans_done_cb(void *args)
     lv_disp_flush_ready(&disp_drv);
     return true;
 }
+#endif
+
+static bool stripe_trans_done_cb(void)
+{
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(stripe_free, &need_yield);
+    return (need_yield == pdTRUE);
+}
+
+static void stripe_init(lvgl_port_config_t *config)
+{
+    for (int i = 0; i < 2; i++) {
+        stripe_buf[i] = (uint16_t *)heap_caps_malloc(config->display.width * STRIPE_LINES * sizeof(uint16_t), MALLOC_CAP_DMA);
+        assert(stripe_buf[i]);
+    }
+    stripe_free = xSemaphoreCreateCounting(2, 2);
+    /* TE sync would tie virtual time steps to the panel's clock */
+    stripe_avoid_tear = config->avoid_tear && !config->virtual_tick;
+    bsp_lcd_trans_done_cb_register(stripe_trans_done_cb);
+}
+
+/**
+ * Push `area` to the panel through the two RGB565 DMA stripes, `fill` converts each stripe
+ * from `src` just before it is queued while the previous one is still on the bus.
+ */
+static void stripe_send(esp_lcd_panel_handle_t panel_handle, const lv_area_t *area, stripe_fill_cb_t fill, const void *src)
+{
+    if (stripe_avoid_tear) {
+        flush_wait();
+    }
+    int max_lines = STRIPE_LINES * disp_drv.hor_res / lv_area_get_width(area);
+    for (int y = area->y1; y <= area->y2; y += max_lines) {
+        int lines = LV_MIN(max_lines, area->y2 - y + 1);
+        xSemaphoreTake(stripe_free, portMAX_DELAY);
+        uint16_t *buf = stripe_buf[stripe_index];
+        stripe_index ^= 1;
+        fill(buf, area, y, lines, src);
+        esp_lcd_panel_draw_bitmap(panel_handle, area->x1, y, area->x2 + 1, y + lines, buf);
+    }
+}
+
+#if LV_COLOR_DEPTH == 8
+static void lut_init(void)
+{
+    /* RGB332 -> RGB565, byte swapped for the panel */
+    for (int i = 0; i < 256; i++) {
+        uint16_t r = ((i >> 5) & 0x7) * 31 / 7;
+        uint16_t g = ((i >> 2) & 0x7) * 63 / 7;
+        uint16_t b = (i & 0x3) * 31 / 3;
+        uint16_t v = (r << 11) | (g << 5) | b;
+        lut_rgb332[i] = (v >> 8) | (v << 8);
+    }
+}
+
+static void lut_fill_stripe(uint16_t *dst, const lv_area_t *area, int y, int lines, const void *src)
+{
+    uint32_t n = lv_area_get_width(area) * lines;
+    const uint8_t *px = (const uint8_t *)src + (y - area->y1) * lv_area_get_width(area);
+    while (n--) {
+        *dst++ = lut_rgb332[*px++];
+    }
+}
+
+static void lut_flush_cb(struct _lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lowres_upscale(color_p, area);
+    heatmap_mark(color_p, area);
+    stripe_send((esp_lcd_panel_handle_t)drv->user_data, area, lut_fill_stripe, color_p);
+    lv_disp_flush_ready(drv);
+}
+#endif
+
+static void rounder_cb(struct _lv_disp_drv_t *drv, lv_area_t *area)
+{
+    if (fbc_store) {
+        area->x1 &= ~(FBC_TILE_PIXELS - 1);
+        area->x2 |= (FBC_TILE_PIXELS - 1);
+    }
+    if (lowres_enabled) {
+        area->x1 &= ~1;
+        area->x2 |= 1;
+        area->y1 &= ~1;
+        area->y2 |= 1;
+    }
+}
+
+#if LV_COLOR_DEPTH == 16
+static void fbc_fill_stripe(uint16_t *dst, const lv_area_t *area, int y, int lines, const void *src)
+{
+    int64_t t0 = esp_timer_get_time();
+    uint32_t tiles = disp_drv.hor_res / FBC_TILE_PIXELS * lines;
+    const uint8_t *slot = fbc_store + (uint32_t)y * disp_drv.hor_res / FBC_TILE_PIXELS * FBC_TILE_BYTES;
+    for (uint32_t i = 0; i < tiles; i++) {
+        fbc_decode_tile(slot, dst);
+        slot += FBC_TILE_BYTES;
+        dst += FBC_TILE_PIXELS;
+    }
+    fbc_frame.decode_us += esp_timer_get_time() - t0;
+}
+
+static void fbc_flush_cb(struct _lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lowres_upscale(color_p, area);
+    heatmap_mark(color_p, area);
+    int64_t t0 = esp_timer_get_time();
+    lv_coord_t w = lv_area_get_width(area);
+    uint32_t tiles_per_row = drv->hor_res / FBC_TILE_PIXELS;
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        uint8_t *slot = fbc_store + (y * tiles_per_row + area->x1 / FBC_TILE_PIXELS) * FBC_TILE_BYTES;
+        for (lv_coord_t x = 0; x < w; x += FBC_TILE_PIXELS) {
+            if (fbc_encode_tile((const uint16_t *)&color_p[x], slot)) {
+                fbc_frame.lossless_tiles++;
+            } else {
+                fbc_frame.lossy_tiles++;
+            }
+            slot += FBC_TILE_BYTES;
+        }
+        color_p += w;
+    }
+    fbc_frame.encode_us += esp_timer_get_time() - t0;
+
+    if (fbc_dirty.x2 < fbc_dirty.x1) {
+        fbc_dirty = *area;
+    } else {
+        _lv_area_join(&fbc_dirty, &fbc_dirty, area);
+    }
+    /* the frame now lives in fbc_store, so the render buffer can be reused right away */
+    lv_disp_flush_ready(drv);
+
+    if (lv_disp_flush_is_last(drv)) {
+        lv_area_t rows;
+        lv_area_set(&rows, 0, fbc_dirty.y1, drv->hor_res - 1, fbc_dirty.y2);
+        stripe_send((esp_lcd_panel_handle_t)drv->user_data, &rows, fbc_fill_stripe, NULL);
+        fbc_frame.rows_sent = lv_area_get_height(&fbc_dirty);
+        fbc_stats = fbc_frame;
+        lv_memset_00(&fbc_frame, sizeof(fbc_frame));
+        lv_area_set(&fbc_dirty, 0, 0, -1, -1);
+    }
+}
+#endif
+
+void lvgl_port_get_fbc_stats(lvgl_port_fbc_stats_t *stats)
+{
+    *stats = fbc_stats;
+}
+
+/**
+ * Put the last frame back on the panel after sleep-in. Full frame modes still hold it (the
+ * front buffer or the compressed store), otherwise it is rendered once.
+ */
+static void display_restore(void)
+{
+    lv_disp_draw_buf_t *draw_buf = disp_drv.draw_buf;
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)disp_drv.user_data;
+    lv_area_t full = {0, 0, disp_drv.hor_res - 1, disp_drv.ver_res - 1};
+    const void *front = (draw_buf->buf_act == draw_buf->buf1) ? draw_buf->buf2 : draw_buf->buf1;
+
+    if (fbc_store || (LV_COLOR_DEPTH == 8 && disp_drv.full_refresh)) {
+#if LV_COLOR_DEPTH == 8
+        stripe_send(panel_handle, &full, lut_fill_stripe, front);
+#elif LV_COLOR_DEPTH == 16
+        stripe_send(panel_handle, &full, fbc_fill_stripe, fbc_store);
+#endif
+        /* both stripes back means the last one has left the bus */
+        for (int i = 0; i < 2; i++) {
+            xSemaphoreTake(stripe_free, portMAX_DELAY);
+        }
+        for (int i = 0; i < 2; i++) {
+            xSemaphoreGive(stripe_free);
+        }
+    } else if (disp_drv.full_refresh && front) {
+        draw_buf->flushing = 1;
+        esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, disp_drv.hor_res, disp_drv.ver_res, front);
+        while (draw_buf->flushing) {
+            vTaskDelay(1);
+        }
+    } else {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+        while (draw_buf->flushing) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+void lvgl_port_set_brightness(uint8_t percent)
+{
+    lvgl_sem_take();
+    if (!percent && !display_off) {
+        /* finish the frame on the bus, then stop everything that could start another one */
+        bsp_lcd_set_brightness(0);
+        while (disp_drv.draw_buf->flushing) {
+            vTaskDelay(1);
+        }
+        bsp_lcd_sleep(true);
+        if (tick_timer) {
+            esp_timer_stop(tick_timer);
+        }
+        pm_set_boost(false);
+        display_off = true;
+        ESP_LOGI(TAG, "display off");
+    } else if (percent && display_off) {
+        pm_set_boost(true);
+        bsp_lcd_sleep(false);
+        display_restore();
+        /* LVGL time stood still, animations continue where they stopped */
+        if (tick_timer) {
+            esp_timer_start_periodic(tick_timer, tick_period * 1000);
+        }
+        encoder_last = bsp_encoder_get_value();
+        display_off = false;
+        bsp_lcd_set_brightness(percent);
+        ESP_LOGI(TAG, "display on");
+    } else {
+        bsp_lcd_set_brightness(percent);
+    }
+    lvgl_sem_give();
+}
 
 static void display_init(lvgl_port_config_t *config)
 {
     esp_lcd_panel_handle_t panel_handle = bsp_lcd_init();
 
     static lv_disp_draw_buf_t disp_buf;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = config->display.width;
+    disp_drv.ver_res = config->display.height;
+    disp_drv.user_data = panel_handle;
+    disp_drv.draw_buf = &disp_buf;
+    disp_drv.monitor_cb = monitor_cb;
+    disp_drv.render_start_cb = render_start_cb;
+    if (config->redraw_heatmap) {
+        heatmap_init(config);
+    }
+    if (config->dma_blend) {
+        dma_enabled = lvgl_dma_init();
+        if (!dma_enabled) {
+            ESP_LOGW(TAG, "no M2M DMA, blending on the CPU");
+        }
+    }
+    if (config->lowres_anim || dma_enabled) {
+        disp_drv.draw_ctx_init = port_draw_ctx_init;
+        disp_drv.draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+    }
+    if (config->lowres_anim) {
+        lowres_enabled = true;
+        disp_drv.rounder_cb = rounder_cb;
+    }
+
+#if LV_COLOR_DEPTH == 16
+    if (config->compress_fb) {
+        /**
+         * LVGL renders partial areas into one small buffer, each area is compressed into
+         * fbc_store and the finished frame is streamed out at once after TE.
+         */
+        fbc_store = (uint8_t *)heap_caps_calloc(1, fbc_store_size(config->display.width, config->display.height), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        lv_color_t *buf = (lv_color_t *)heap_caps_malloc(config->display.buf_size * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        assert(fbc_store && buf);
+        lv_disp_draw_buf_init(&disp_buf, buf, NULL, config->display.buf_size);
+        disp_drv.flush_cb = fbc_flush_cb;
+        disp_drv.rounder_cb = rounder_cb;
+        lv_disp_drv_register(&disp_drv);
+        stripe_init(config);
+        return;
+    }
+#else
+    if (config->compress_fb) {
+        ESP_LOGW(TAG, "frame buffer compression needs LV_COLOR_DEPTH 16");
+    }
+#endif
+
     lv_color_t *buf_1 = (lv_color_t *)heap_caps_malloc(config->display.buf_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
     lv_color_t *buf_2 = (lv_color_t *)heap_caps_malloc(config->display.buf_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
     lv_disp_draw_buf_init(&disp_buf, buf_1, buf_2, config->display.buf_size);
+    /* a full refresh draws everything, only partial areas show what was invalidated */
+    disp_drv.full_refresh = (config->avoid_tear && !config->redraw_heatmap) ? 1 : 0;
 
-    lv_disp_drv_init(&disp_drv);
-    disp_drv.draw_buf = &disp_buf;
+#if LV_COLOR_DEPTH == 8
+    /* render at 8 bpp and expand to RGB565 stripe by stripe on the way to SPI */
+    lut_init();
+    disp_drv.flush_cb = lut_flush_cb;
+    lv_disp_drv_register(&disp_drv);
+    stripe_init(config);
+#else
     disp_drv.flush_cb = flush_cb;
-    disp_drv.hor_res = config->display.width;
-    disp_drv.ver_res = config->display.height;
-    disp_drv.full_refresh = (config->avoid_tear) ? 1 : 0;
-    disp_drv.user_data = panel_handle;
     lv_disp_drv_register(&disp_drv);
     bsp_lcd_trans_done_cb_register(trans_done_cb);
+#endif
 }
 
 static void tick_inc(void *arg)
@@ -122,7 +929,11 @@ static void tick_inc(void *arg)
 
 static void tick_init(uint8_t period)
 {
-    esp_timer_handle_t timer;
+    tick_period = period;
+    if (tick_virtual) {
+        return;
+    }
+
     esp_timer_create_args_t args = {
         .name = "lvgl_tick",
         .callback = tick_inc,
@@ -130,17 +941,54 @@ static void tick_init(uint8_t period)
         .skip_unhandled_events = true,
         .arg = (void *)period,
     };
-    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, period * 1000));
+    ESP_ERROR_CHECK(esp_timer_create(&args, &tick_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer, period * 1000));
+}
+
+uint32_t lvgl_port_advance(uint32_t ms)
+{
+    if (!tick_virtual || display_off) {
+        return LV_NO_TIMER_READY;
+    }
+
+    lvgl_sem_take();
+    lv_tick_inc(ms);
+    lowres_update();
+    uint32_t next = lv_timer_handler();
+    /* end every step with the panel idle, the next one starts from the same state */
+    while (disp_drv.draw_buf->flushing) {
+        taskYIELD();
+    }
+    lvgl_sem_give();
+    return next;
 }
 
 static void lvgl_task(void *arg)
 {
     uint8_t period = (uint8_t)arg;
     for (;;) {
+        if (display_off) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
         xSemaphoreTake(sem_lock, portMAX_DELAY);
-        lv_timer_handler();
+        lowres_update();
+        uint32_t wait = lv_timer_handler();
+        pm_update();
+        if (refr_adaptive) {
+            wait = LV_MIN(wait, refr_update());
+        }
         xSemaphoreGive(sem_lock);
-        vTaskDelay(pdMS_TO_TICKS(period));
+
+        if (refr_active) {
+            refr_stats.active.wakeups++;
+        } else {
+            refr_stats.idle.wakeups++;
+        }
+        if (refr_adaptive) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LV_CLAMP(1, wait, REFR_MAX_SLEEP)));
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(period));
+        }
     }
 }
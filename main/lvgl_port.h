@@ -21,11 +21,101 @@ typedef struct {
         int priority;
     } task;
     bool avoid_tear;
+    bool compress_fb;
+    bool lowres_anim;
+    bool cpu_scaling;       /* hold the max CPU frequency only while rendering, needs CONFIG_PM_ENABLE */
+    bool adaptive_refr;     /* refresh at the TE rate while animating, only on demand when static */
+    bool virtual_tick;      /* no tick timer and no LVGL task, time moves only with lvgl_port_advance() */
+    bool dma_blend;         /* large opaque fills and copies by GDMA while the CPU draws elsewhere */
+    bool redraw_heatmap;    /* count redraws per tile and tint flushed areas by that count, debug only */
 } lvgl_port_config_t;
 
+typedef struct {
+    uint32_t lossless_tiles;
+    uint32_t lossy_tiles;
+    uint32_t encode_us;
+    uint32_t decode_us;
+    uint32_t rows_sent;
+} lvgl_port_fbc_stats_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t last_ms;
+    uint32_t max_ms;
+    uint32_t avg_ms;        /* exponential average over ~16 frames */
+    uint32_t last_px;
+    uint32_t last_us;       /* from render start to the end of the refresh, without the waits for the panel */
+    uint32_t total_us;
+} lvgl_port_frame_stats_t;
+
+typedef struct {
+    uint32_t boost_ms;      /* time at the max CPU frequency */
+    uint32_t idle_ms;       /* time the port let the CPU drop to the min frequency */
+    uint32_t boosts;
+} lvgl_port_pm_stats_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t wakeups;       /* iterations of the LVGL task */
+    uint32_t time_ms;
+} lvgl_port_refr_state_stats_t;
+
+typedef struct {
+    lvgl_port_refr_state_stats_t active;    /* animations running or recent input */
+    lvgl_port_refr_state_stats_t idle;
+    uint32_t te_period_us;
+} lvgl_port_refr_stats_t;
+
+#define LVGL_PORT_HEATMAP_TILE  (16)
+
+typedef void (*lvgl_port_frame_cb_t)(uint32_t render_us, uint32_t px);
+
 void lvgl_sem_take(void);
 void lvgl_sem_give(void);
 void lvgl_port(lvgl_port_config_t *config);
+void lvgl_port_get_fbc_stats(lvgl_port_fbc_stats_t *stats);
+void lvgl_port_get_frame_stats(lvgl_port_frame_stats_t *stats, bool reset);
+
+/**
+ * @return frames completed since boot, never reset unlike the frame stats
+ */
+uint32_t lvgl_port_get_frame_count(void);
+void lvgl_port_get_pm_stats(lvgl_port_pm_stats_t *stats, bool reset);
+void lvgl_port_get_refr_stats(lvgl_port_refr_stats_t *stats, bool reset);
+
+/**
+ * Call `cb` from the LVGL task at the end of every refresh with its CPU time, NULL removes it.
+ */
+void lvgl_port_set_frame_cb(lvgl_port_frame_cb_t cb);
+
+/**
+ * Copy the redraw counters of `redraw_heatmap`, one per tile of LVGL_PORT_HEATMAP_TILE pixels
+ * squared, row by row. `counts` holds a rounded up (width / tile) * (height / tile) entries.
+ * @return frames since the last reset, 0 when the heat map is off
+ */
+uint32_t lvgl_port_get_heatmap(uint16_t *counts, bool reset);
+
+/**
+ * Set the backlight. 0 also stops rendering, LVGL time and the SPI traffic and puts the panel
+ * to sleep; the next non-zero value wakes it and puts the last frame back before the backlight
+ * comes on.
+ */
+void lvgl_port_set_brightness(uint8_t percent);
+
+/**
+ * Virtual time only: move LVGL time forward by `ms`, run every timer that became due (rendering
+ * included) and wait until the frame is on the panel. Animations, timers and frame contents
+ * then only depend on the sequence of calls, not on the scheduler.
+ * @return ms until the next LVGL timer is due, advancing by that skips the idle time
+ */
+uint32_t lvgl_port_advance(uint32_t ms);
+
+/**
+ * Render at half resolution while at least one hold is active (needs `lowres_anim`).
+ * Call from the LVGL task, e.g. when a fast animation starts and from its ready callback.
+ */
+void lvgl_port_lowres_hold(void);
+void lvgl_port_lowres_release(void);
 
 #ifdef __cplusplus
 }
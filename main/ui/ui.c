@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "esp_system.h"
+#include "esp_heap_caps.h"
 #ifdef ESP_IDF_VERSION
 #include "esp_log.h"
 #include "bsp_indev.h"
@@ -8,13 +9,28 @@
 #include "lvgl_port.h"
 #include "ui.h"
 #include "ui_menu.h"
+#include "ui_asset_pool.h"
+#include "ui_img_runs.h"
+#include "ui_profiler.h"
+#include "ui_state.h"
+#include "ui_theme.h"
 #include <math.h>
 
+#define UI_ASSET_POOL_BUDGET    (40 * 1024)     /* at most, see ui_init() */
+#define UI_IMG_RUNS_BUDGET      (32 * 1024)
+#define UI_PAGE_HEAP_RESERVE    (44 * 1024)     /* washing clip playback: one 43,200 B frame */
+#define UI_LIGHT_THEME          1   /* 0 keeps LVGL's default theme, e.g. to compare the style usage */
+#define UI_PROFILER             0   /* 1 logs the slowest objects of every frame over the budget */
+#define UI_PROFILER_BUDGET_US   (16000)
+
 static const char *TAG = "ui";
 static lv_group_t *group;
 
 void ui_init(void)
 {
+#if UI_LIGHT_THEME
+    lv_disp_set_theme(NULL, ui_theme_init(lv_disp_get_default()));
+#endif
     group = lv_group_create();
     lv_group_set_default(group);
     lv_indev_t *indev = lv_indev_get_next(NULL);
@@ -34,6 +50,25 @@ void ui_init(void)
 
     // }
 
+    /**
+     * The caches get what the frame buffers leave of the internal heap, after the reserve for
+     * the page that needs the most while it's open. Measured here, it depends on the port
+     * config and the sdkconfig. The washing clip is decoded into one 120x120 ARGB8565 frame and
+     * read from its partition; only the recording, once per firmware, needs a second frame and
+     * takes it from the asset pool, see ui_washing_init().
+     */
+    uint32_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint32_t spare = (free_bytes > UI_PAGE_HEAP_RESERVE) ? free_bytes - UI_PAGE_HEAP_RESERVE : 0;
+    uint32_t pool_budget = LV_MIN(UI_ASSET_POOL_BUDGET, spare * UI_ASSET_POOL_BUDGET / (UI_ASSET_POOL_BUDGET + UI_IMG_RUNS_BUDGET));
+    uint32_t runs_budget = LV_MIN(UI_IMG_RUNS_BUDGET, spare - pool_budget);
+    ESP_LOGI(TAG, "%u B internal heap free: asset pool %u B, image runs %u B, %u B kept for pages",
+             free_bytes, pool_budget, runs_budget, free_bytes - pool_budget - runs_budget);
+    ui_asset_pool_init(pool_budget);
+    ui_img_runs_init(runs_budget);
+#if UI_PROFILER
+    ui_profiler_init(UI_PROFILER_BUDGET_US);
+#endif
+    ui_state_init();
     ui_menu_init();
 }
 
@@ -45,4 +80,9 @@ void ui_add_obj_to_encoder_group(lv_obj_t *obj)
 void ui_remove_all_objs_from_encoder_group(void)
 {
     lv_group_remove_all_objs(group);
-}
\ No newline at end of file
+}
+
+lv_obj_t *ui_get_top_page(void)
+{
+    return lv_obj_get_child(lv_scr_act(), -1);
+}
@@ -13,6 +13,12 @@ void ui_init(void);
 void ui_add_obj_to_encoder_group(lv_obj_t *obj);
 void ui_remove_all_objs_from_encoder_group(void);
 
+/**
+ * @return the page on top: every page is a child of the active screen and the page opened last
+ * is its last child, the menu while no app is open
+ */
+lv_obj_t *ui_get_top_page(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "lvgl.h"
+#include "ui_asset_pool.h"
+
+#define POOL_MAX_ENTRIES    (12)
+
+typedef struct {
+    const lv_img_dsc_t *src;    /* original in flash */
+    lv_img_dsc_t dsc;           /* copy pointing at the internal RAM data */
+} pool_entry_t;
+
+static pool_entry_t entries[POOL_MAX_ENTRIES];
+static ui_asset_pool_stats_t stats;
+
+static bool in_set(const lv_img_dsc_t *src, const lv_img_dsc_t *const *assets, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (assets[i] == src) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static pool_entry_t *find_by_src(const lv_img_dsc_t *src)
+{
+    for (int i = 0; i < POOL_MAX_ENTRIES; i++) {
+        if (entries[i].src == src) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static lv_obj_tree_walk_res_t remap_cb(lv_obj_t *obj, void *user_data)
+{
+    bool to_ram = (bool)user_data;
+
+    /* subclasses too, e.g. the run encoded images */
+    if (!lv_obj_has_class(obj, &lv_img_class)) {
+        return LV_OBJ_TREE_WALK_NEXT;
+    }
+    const void *src = lv_img_get_src(obj);
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) {
+        return LV_OBJ_TREE_WALK_NEXT;
+    }
+    for (int i = 0; i < POOL_MAX_ENTRIES; i++) {
+        pool_entry_t *e = &entries[i];
+        if (!e->src) {
+            continue;
+        }
+        if (to_ram && src == e->src) {
+            lv_img_set_src(obj, &e->dsc);
+            break;
+        } else if (!to_ram && src == &e->dsc) {
+            lv_img_set_src(obj, e->src);
+            break;
+        }
+    }
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static void evict(pool_entry_t *e)
+{
+    free((void *)e->dsc.data);
+    stats.used -= e->dsc.data_size;
+    stats.resident--;
+    lv_memset_00(e, sizeof(pool_entry_t));
+}
+
+void ui_asset_pool_init(uint32_t budget)
+{
+    lv_memset_00(entries, sizeof(entries));
+    lv_memset_00(&stats, sizeof(stats));
+    stats.budget = budget;
+}
+
+void ui_asset_pool_activate(const lv_img_dsc_t *const *assets, size_t count)
+{
+    /* point every image back to flash before its copy goes away */
+    lv_obj_tree_walk(lv_scr_act(), remap_cb, (void *)false);
+    for (int i = 0; i < POOL_MAX_ENTRIES; i++) {
+        if (entries[i].src && !in_set(entries[i].src, assets, count)) {
+            evict(&entries[i]);
+        }
+    }
+
+    stats.rejected = 0;
+    for (size_t i = 0; i < count; i++) {
+        const lv_img_dsc_t *src = assets[i];
+        if (find_by_src(src)) {
+            continue;
+        }
+        pool_entry_t *e = find_by_src(NULL);
+        void *data = NULL;
+        if (e && stats.used + src->data_size <= stats.budget) {
+            data = heap_caps_malloc(src->data_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!data) {
+            stats.rejected++;
+            continue;
+        }
+        memcpy(data, src->data, src->data_size);
+        e->src = src;
+        e->dsc = *src;
+        e->dsc.data = data;
+        stats.used += src->data_size;
+        stats.copied_bytes += src->data_size;
+        stats.resident++;
+    }
+
+    lv_obj_tree_walk(lv_scr_act(), remap_cb, (void *)true);
+}
+
+const lv_img_dsc_t *ui_asset_pool_get(const lv_img_dsc_t *src)
+{
+    pool_entry_t *e = find_by_src(src);
+    return e ? &e->dsc : src;
+}
+
+const lv_img_dsc_t *ui_asset_pool_get_src(const lv_img_dsc_t *dsc)
+{
+    for (int i = 0; i < POOL_MAX_ENTRIES; i++) {
+        if (entries[i].src && dsc == &entries[i].dsc) {
+            return entries[i].src;
+        }
+    }
+    return dsc;
+}
+
+void ui_asset_pool_get_stats(ui_asset_pool_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,43 @@
+#ifndef UI_ASSET_POOL_H__
+#define UI_ASSET_POOL_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t budget;
+    uint32_t used;
+    uint16_t resident;
+    uint16_t rejected;      /* assets of the active set that didn't fit */
+    uint32_t copied_bytes;  /* flash reads spent on filling the pool since boot */
+} ui_asset_pool_stats_t;
+
+void ui_asset_pool_init(uint32_t budget);
+
+/**
+ * Make `assets` (hottest first) the resident set: assets of the previous set are dropped,
+ * new ones are copied to internal RAM while the budget allows and every lv_img on the active
+ * screen is switched to the copy it should use.
+ */
+void ui_asset_pool_activate(const lv_img_dsc_t *const *assets, size_t count);
+
+/**
+ * @return the RAM copy of `src` if it's resident, `src` otherwise
+ */
+const lv_img_dsc_t *ui_asset_pool_get(const lv_img_dsc_t *src);
+
+/**
+ * @return the original of `dsc` if it's a RAM copy, `dsc` otherwise
+ */
+const lv_img_dsc_t *ui_asset_pool_get_src(const lv_img_dsc_t *dsc);
+
+void ui_asset_pool_get_stats(ui_asset_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,485 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_system.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "esp_app_desc.h"
+#else
+#include "esp_ota_ops.h"
+#endif
+#include "lvgl.h"
+#include "ui_baked_anim.h"
+
+/**
+ * Clip layout (same in flash and in the RAM pool):
+ *   header | index[frames + 1] | delta records
+ * index[0] is the key frame (XOR against an all-zero frame), index[i] is frame i XOR frame i-1,
+ * index[frames] wraps the last frame back to frame 0.
+ * A delta record is a list of [u16 skip][u16 len][len XOR bytes] tokens, longer skips are
+ * split with zero-length tokens.
+ */
+#define CLIP_MAGIC          0x4b414e42  /* "BNAK" */
+#define CLIP_CF             LV_IMG_CF_TRUE_COLOR_ALPHA
+#define CLIP_SECTOR_SIZE    4096
+#define STAGE_SIZE          512
+#define MIN_ZERO_GAP        4           /* shorter zero runs stay inside a literal */
+#define BAKE_PERIOD_MS      30
+#define BAKE_SLICE_MS       15          /* recording time per slice, at least one frame */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t hash;
+    uint16_t w;
+    uint16_t h;
+    uint16_t frames;
+    uint16_t frame_ms;
+    uint32_t size;
+} clip_header_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+    lv_area_t dirty;    /* relative to the recorded object */
+} clip_entry_t;
+
+typedef struct {
+    uint8_t *ram;
+    uint32_t cap;
+    const esp_partition_t *part;
+    uint32_t erased;
+    uint32_t pos;
+    uint8_t stage[STAGE_SIZE];
+    uint32_t staged;
+    bool overflow;
+} clip_sink_t;
+
+struct _ui_baked_anim_t {
+    lv_obj_t *src;
+    lv_obj_t *img;
+    lv_timer_t *timer;
+    lv_img_dsc_t dsc;
+    uint8_t *frame;
+    uint32_t frame_bytes;
+    const clip_header_t *header;
+    const clip_entry_t *index;
+    const uint8_t *clip;
+    uint8_t *ram;
+    const esp_partition_t *part;
+    esp_partition_mmap_handle_t mmap;
+    bool mapped;
+    uint32_t cur;
+    uint64_t decode_us_sum;
+    ui_baked_anim_stats_t stats;
+    ui_baked_anim_config_t config;
+    /* recording, between the slices of bake_timer */
+    lv_timer_t *bake_timer;
+    clip_sink_t *sink;
+    clip_header_t bake_header;
+    clip_entry_t *bake_index;
+    uint8_t *prev;
+    uint32_t bake_next;
+    int64_t bake_us;
+};
+
+static const char *TAG = "baked_anim";
+
+static uint32_t clip_hash(const ui_baked_anim_config_t *config, uint16_t w, uint16_t h)
+{
+    /* FNV-1a over the geometry and the firmware image, so a reflash invalidates stale clips */
+    uint32_t hash = 2166136261u;
+    uint32_t words[] = {w, h, CLIP_CF, config->loop_ms, config->frame_ms};
+    const uint8_t *p = (const uint8_t *)words;
+    for (size_t i = 0; i < sizeof(words); i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    const esp_app_desc_t *app = esp_app_get_description();
+#else
+    const esp_app_desc_t *app = esp_ota_get_app_description();
+#endif
+    for (size_t i = 0; i < sizeof(app->app_elf_sha256); i++) {
+        hash = (hash ^ app->app_elf_sha256[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void sink_write_raw(clip_sink_t *sink, uint32_t offset, const void *data, uint32_t len)
+{
+    if (sink->overflow) {
+        return;
+    }
+    if (offset + len > sink->cap) {
+        sink->overflow = true;
+        return;
+    }
+    if (sink->ram) {
+        memcpy(sink->ram + offset, data, len);
+        return;
+    }
+    while (sink->erased < offset + len) {
+        if (esp_partition_erase_range(sink->part, sink->erased, CLIP_SECTOR_SIZE) != ESP_OK) {
+            sink->overflow = true;
+            return;
+        }
+        sink->erased += CLIP_SECTOR_SIZE;
+    }
+    if (esp_partition_write(sink->part, offset, data, len) != ESP_OK) {
+        sink->overflow = true;
+    }
+}
+
+static void sink_flush(clip_sink_t *sink)
+{
+    sink_write_raw(sink, sink->pos, sink->stage, sink->staged);
+    sink->pos += sink->staged;
+    sink->staged = 0;
+}
+
+static void sink_put(clip_sink_t *sink, const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+    while (len) {
+        uint32_t n = LV_MIN(len, STAGE_SIZE - sink->staged);
+        memcpy(sink->stage + sink->staged, p, n);
+        sink->staged += n;
+        p += n;
+        len -= n;
+        if (sink->staged == STAGE_SIZE) {
+            sink_flush(sink);
+        }
+    }
+}
+
+static uint32_t sink_tell(clip_sink_t *sink)
+{
+    return sink->pos + sink->staged;
+}
+
+static void delta_encode(clip_sink_t *sink, const uint8_t *cur, const uint8_t *prev, uint32_t n,
+                         uint16_t w, clip_entry_t *entry)
+{
+    uint32_t stride = w * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    lv_coord_t x1 = LV_COORD_MAX, y1 = LV_COORD_MAX, x2 = -1, y2 = -1;
+    uint32_t i = 0, last = 0;
+
+    entry->offset = sink_tell(sink);
+    while (i < n) {
+        if ((cur[i] ^ prev[i]) == 0) {
+            i++;
+            continue;
+        }
+        /* extend the literal until a long enough run of unchanged bytes */
+        uint32_t start = i, end = i, zeros = 0;
+        while (end < n && zeros < MIN_ZERO_GAP && end - start < UINT16_MAX - MIN_ZERO_GAP) {
+            zeros = ((cur[end] ^ prev[end]) == 0) ? zeros + 1 : 0;
+            end++;
+        }
+        end -= zeros;
+
+        while (start - last > UINT16_MAX) {
+            uint16_t filler[2] = {UINT16_MAX, 0};
+            sink_put(sink, filler, sizeof(filler));
+            last += UINT16_MAX;
+        }
+        uint16_t token[2] = {(uint16_t)(start - last), (uint16_t)(end - start)};
+        sink_put(sink, token, sizeof(token));
+        for (uint32_t k = start; k < end; k++) {
+            uint8_t x = cur[k] ^ prev[k];
+            sink_put(sink, &x, 1);
+        }
+
+        lv_coord_t ys = start / stride, ye = (end - 1) / stride;
+        y1 = LV_MIN(y1, ys);
+        y2 = LV_MAX(y2, ye);
+        if (ys == ye) {
+            x1 = LV_MIN(x1, (lv_coord_t)((start % stride) / LV_IMG_PX_SIZE_ALPHA_BYTE));
+            x2 = LV_MAX(x2, (lv_coord_t)(((end - 1) % stride) / LV_IMG_PX_SIZE_ALPHA_BYTE));
+        } else {
+            x1 = 0;
+            x2 = w - 1;
+        }
+        last = i = end;
+    }
+    entry->size = sink_tell(sink) - entry->offset;
+    if (y2 < 0) {
+        lv_area_set(&entry->dirty, 0, 0, -1, -1);
+    } else {
+        lv_area_set(&entry->dirty, x1, y1, x2, y2);
+    }
+}
+
+static void delta_apply(uint8_t *frame, const uint8_t *rec, uint32_t size)
+{
+    const uint8_t *end = rec + size;
+    uint8_t *dst = frame;
+    while (rec < end) {
+        uint16_t token[2];
+        memcpy(token, rec, sizeof(token));
+        rec += sizeof(token);
+        dst += token[0];
+        for (uint16_t k = 0; k < token[1]; k++) {
+            *dst++ ^= *rec++;
+        }
+    }
+}
+
+static void clip_next_frame(lv_timer_t *t)
+{
+    ui_baked_anim_t *ba = t->user_data;
+    ba->cur = (ba->cur % ba->header->frames) + 1;
+
+    const clip_entry_t *entry = &ba->index[ba->cur];
+    int64_t t0 = esp_timer_get_time();
+    delta_apply(ba->frame, ba->clip + entry->offset, entry->size);
+    uint32_t us = esp_timer_get_time() - t0;
+
+    ba->stats.played++;
+    ba->decode_us_sum += us;
+    ba->stats.decode_us_avg = ba->decode_us_sum / ba->stats.played;
+    ba->stats.decode_us_max = LV_MAX(ba->stats.decode_us_max, us);
+
+    if (entry->dirty.x2 >= entry->dirty.x1) {
+        lv_area_t area = entry->dirty;
+        lv_area_move(&area, ba->img->coords.x1, ba->img->coords.y1);
+        lv_obj_invalidate_area(ba->img, &area);
+    }
+    if (ba->cur == ba->header->frames) {
+        ba->cur = 0;
+    }
+}
+
+static bool clip_map(ui_baked_anim_t *ba, const clip_header_t *header)
+{
+    if (ba->ram) {
+        ba->clip = ba->ram;
+    } else {
+        const void *ptr;
+        if (esp_partition_mmap(ba->part, 0, header->size, ESP_PARTITION_MMAP_DATA, &ptr, &ba->mmap) != ESP_OK) {
+            return false;
+        }
+        ba->mapped = true;
+        ba->clip = ptr;
+    }
+    ba->header = (const clip_header_t *)ba->clip;
+    ba->index = (const clip_entry_t *)(ba->clip + sizeof(clip_header_t));
+    return true;
+}
+
+static bool clip_play(ui_baked_anim_t *ba, const clip_header_t *header)
+{
+    if (!clip_map(ba, header)) {
+        return false;
+    }
+
+    /* start from the key frame */
+    lv_memset_00(ba->frame, ba->frame_bytes);
+    delta_apply(ba->frame, ba->clip + ba->index[0].offset, ba->index[0].size);
+    ba->dsc.header.always_zero = 0;
+    ba->dsc.header.w = header->w;
+    ba->dsc.header.h = header->h;
+    ba->dsc.header.cf = CLIP_CF;
+    ba->dsc.data_size = ba->frame_bytes;
+    ba->dsc.data = ba->frame;
+
+    ba->img = lv_img_create(lv_obj_get_parent(ba->src));
+    lv_img_set_src(ba->img, &ba->dsc);
+    lv_obj_align_to(ba->img, ba->src, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_move_to_index(ba->img, lv_obj_get_index(ba->src));
+    lv_obj_add_flag(ba->src, LV_OBJ_FLAG_HIDDEN);
+
+    ba->stats.frames = header->frames;
+    ba->stats.clip_bytes = header->size;
+    ba->stats.frame_bytes = ba->frame_bytes;
+    ba->timer = lv_timer_create(clip_next_frame, header->frame_ms, ba);
+    if (ba->config.ready_cb) {
+        ba->config.ready_cb(ba->config.user_data);
+    }
+    return true;
+}
+
+static void bake_free(ui_baked_anim_t *ba)
+{
+    if (ba->bake_timer) {
+        lv_timer_del(ba->bake_timer);
+        ba->bake_timer = NULL;
+    }
+    lv_mem_free(ba->bake_index);
+    lv_mem_free(ba->sink);
+    free(ba->prev);
+    ba->bake_index = NULL;
+    ba->sink = NULL;
+    ba->prev = NULL;
+}
+
+static void bake_finish(ui_baked_anim_t *ba)
+{
+    clip_sink_t *sink = ba->sink;
+    clip_header_t header = ba->bake_header;
+
+    sink_flush(sink);
+    header.size = sink->pos;
+    sink_write_raw(sink, sizeof(clip_header_t), ba->bake_index, (header.frames + 1) * sizeof(clip_entry_t));
+    sink_write_raw(sink, 0, &header, sizeof(clip_header_t));
+    bool ok = !sink->overflow;
+    ESP_LOGI(TAG, "baked %u frames into %u bytes (%u per raw frame) in %u ms%s",
+             header.frames, header.size, ba->frame_bytes, (uint32_t)(ba->bake_us / 1000),
+             ok ? "" : ", over budget");
+    bake_free(ba);
+
+    if (ok && ba->ram) {
+        uint8_t *shrunk = heap_caps_realloc(ba->ram, header.size, MALLOC_CAP_8BIT);
+        if (shrunk) {
+            ba->ram = shrunk;
+        }
+    }
+    if (!ok || !clip_play(ba, &header)) {
+        /* the live loop goes on, the handle only waits for ui_baked_anim_delete() */
+        free(ba->ram);
+        ba->ram = NULL;
+    }
+}
+
+/**
+ * Record frames for up to BAKE_SLICE_MS and give the pose back to the live loop, so the refresh
+ * that follows shows the live frame and not a recorded one.
+ */
+static void bake_slice(lv_timer_t *t)
+{
+    ui_baked_anim_t *ba = t->user_data;
+    const ui_baked_anim_config_t *config = &ba->config;
+    uint32_t frames = ba->bake_header.frames;
+    int64_t t0 = esp_timer_get_time();
+
+    /* the extra pass re-poses frame 0 to record the wrap-around delta */
+    while (ba->bake_next <= frames && !ba->sink->overflow) {
+        uint32_t i = ba->bake_next++;
+        config->pose_cb((i % frames) * config->frame_ms, config->user_data);
+        lv_obj_update_layout(ba->src);
+        lv_snapshot_take_to_buf(ba->src, CLIP_CF, &ba->dsc, ba->frame, ba->frame_bytes);
+        delta_encode(ba->sink, ba->frame, ba->prev, ba->frame_bytes, ba->bake_header.w, &ba->bake_index[i]);
+        memcpy(ba->prev, ba->frame, ba->frame_bytes);
+        if (esp_timer_get_time() - t0 >= BAKE_SLICE_MS * 1000) {
+            break;
+        }
+    }
+    ba->bake_us += esp_timer_get_time() - t0;
+    if (config->restore_cb) {
+        config->restore_cb(config->user_data);
+    }
+    if (ba->bake_next > frames || ba->sink->overflow) {
+        bake_finish(ba);
+    }
+}
+
+static bool bake_start(ui_baked_anim_t *ba, const clip_header_t *header)
+{
+    ba->bake_header = *header;
+    ba->bake_index = lv_mem_alloc((header->frames + 1) * sizeof(clip_entry_t));
+    /* only the recording needs it, it's freed as soon as the clip is written */
+    ba->prev = heap_caps_calloc(1, ba->frame_bytes, MALLOC_CAP_8BIT);
+    if (!ba->bake_index || !ba->prev) {
+        ESP_LOGW(TAG, "no memory to record, a second %u byte frame", ba->frame_bytes);
+        return false;
+    }
+    ba->sink->pos = sizeof(clip_header_t) + (header->frames + 1) * sizeof(clip_entry_t);
+    ba->bake_timer = lv_timer_create(bake_slice, BAKE_PERIOD_MS, ba);
+    return true;
+}
+
+ui_baked_anim_t *ui_baked_anim_create(const ui_baked_anim_config_t *config)
+{
+    LV_ASSERT_NULL(config->obj);
+    LV_ASSERT_NULL(config->pose_cb);
+
+    ui_baked_anim_t *ba = lv_mem_alloc(sizeof(ui_baked_anim_t));
+    LV_ASSERT_MALLOC(ba);
+    lv_memset_00(ba, sizeof(ui_baked_anim_t));
+    ba->src = config->obj;
+    ba->config = *config;
+
+    lv_obj_update_layout(ba->src);
+    ba->frame_bytes = lv_snapshot_buf_size_needed(ba->src, CLIP_CF);
+    ba->frame = heap_caps_calloc(1, ba->frame_bytes, MALLOC_CAP_8BIT);
+    ba->sink = lv_mem_alloc(sizeof(clip_sink_t));
+    if (!ba->frame || !ba->sink) {
+        ESP_LOGW(TAG, "no memory for a %u byte frame", ba->frame_bytes);
+        goto fail;
+    }
+    lv_memset_00(ba->sink, sizeof(clip_sink_t));
+
+    /* a first snapshot gives the real frame geometry, including any extended draw area */
+    lv_snapshot_take_to_buf(ba->src, CLIP_CF, &ba->dsc, ba->frame, ba->frame_bytes);
+    clip_header_t header = {
+        .magic = CLIP_MAGIC,
+        .w = ba->dsc.header.w,
+        .h = ba->dsc.header.h,
+        .frames = config->loop_ms / config->frame_ms,
+        .frame_ms = config->frame_ms,
+    };
+    header.hash = clip_hash(config, header.w, header.h);
+
+    if (config->partition_label) {
+        ba->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
+        if (!ba->part) {
+            ESP_LOGW(TAG, "partition %s not found", config->partition_label);
+            goto fail;
+        }
+        clip_header_t stored;
+        esp_partition_read(ba->part, 0, &stored, sizeof(stored));
+        if (stored.magic == CLIP_MAGIC && stored.hash == header.hash && stored.frames == header.frames) {
+            bake_free(ba);
+            if (!clip_play(ba, &stored)) {
+                goto fail;
+            }
+            return ba;
+        }
+        ba->sink->part = ba->part;
+        ba->sink->cap = ba->part->size;
+    } else {
+        ba->ram = heap_caps_malloc(config->ram_budget, MALLOC_CAP_8BIT);
+        if (!ba->ram) {
+            goto fail;
+        }
+        ba->sink->ram = ba->ram;
+        ba->sink->cap = config->ram_budget;
+    }
+    if (!bake_start(ba, &header)) {
+        goto fail;
+    }
+    return ba;
+
+fail:
+    bake_free(ba);
+    free(ba->frame);
+    free(ba->ram);
+    lv_mem_free(ba);
+    return NULL;
+}
+
+void ui_baked_anim_get_stats(ui_baked_anim_t *ba, ui_baked_anim_stats_t *stats)
+{
+    *stats = ba->stats;
+}
+
+void ui_baked_anim_delete(ui_baked_anim_t *ba)
+{
+    if (!ba) {
+        return;
+    }
+    ESP_LOGI(TAG, "played %u frames, decode avg %u us max %u us, clip %u bytes",
+             ba->stats.played, ba->stats.decode_us_avg, ba->stats.decode_us_max, ba->stats.clip_bytes);
+    bake_free(ba);
+    if (ba->timer) {
+        lv_timer_del(ba->timer);
+    }
+    if (ba->mapped) {
+        esp_partition_munmap(ba->mmap);
+    }
+    free(ba->ram);
+    free(ba->frame);
+    lv_mem_free(ba);
+}
@@ -0,0 +1,58 @@
+#ifndef UI_BAKED_ANIM_H__
+#define UI_BAKED_ANIM_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pose the recorded objects at time `t_ms` of the loop. Called once per frame while baking.
+ */
+typedef void (*ui_baked_anim_pose_cb_t)(uint32_t t_ms, void *user_data);
+
+/**
+ * Recording runs in slices between frames while the live loop keeps playing. `restore_cb` puts
+ * the live pose back after each slice, `ready_cb` is called once playback has taken over and the
+ * live loop can stop. Both are optional.
+ */
+typedef void (*ui_baked_anim_cb_t)(void *user_data);
+
+typedef struct {
+    lv_obj_t *obj;                  /* root of the region to record, hidden during playback */
+    uint32_t loop_ms;               /* length of one deterministic loop */
+    uint32_t frame_ms;              /* playback period, loop_ms must be a multiple of it */
+    ui_baked_anim_pose_cb_t pose_cb;
+    ui_baked_anim_cb_t restore_cb;
+    ui_baked_anim_cb_t ready_cb;
+    void *user_data;
+    const char *partition_label;    /* data partition to keep the clip in, NULL for the RAM pool */
+    uint32_t ram_budget;            /* max bytes of the RAM pool when no partition is used */
+} ui_baked_anim_config_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t clip_bytes;
+    uint32_t frame_bytes;
+    uint32_t decode_us_avg;
+    uint32_t decode_us_max;
+    uint32_t played;
+} ui_baked_anim_stats_t;
+
+typedef struct _ui_baked_anim_t ui_baked_anim_t;
+
+/**
+ * Reload the loop of `config->obj` from flash and play it back right away, or start recording
+ * it. Returns NULL if there is no memory or partition for it; a recording that turns out not to
+ * fit stops without calling `ready_cb`. The caller keeps compositing live in both cases.
+ */
+ui_baked_anim_t *ui_baked_anim_create(const ui_baked_anim_config_t *config);
+void ui_baked_anim_delete(ui_baked_anim_t *ba);
+void ui_baked_anim_get_stats(ui_baked_anim_t *ba, ui_baked_anim_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include "lvgl.h"
+#include "src/misc/lv_gc.h"
+#include "ui_census.h"
+
+typedef struct {
+    const lv_obj_class_t *class_p;
+    const char *name;
+} class_name_t;
+
+/* lv_obj_class_t has no name, only the widgets this UI uses are listed */
+static const class_name_t class_names[UI_CLASS_NUM] = {
+    [UI_CLASS_OBJ] = {&lv_obj_class, "obj"},
+    [UI_CLASS_LABEL] = {&lv_label_class, "label"},
+    [UI_CLASS_IMG] = {&lv_img_class, "img"},
+    [UI_CLASS_BTN] = {&lv_btn_class, "btn"},
+    [UI_CLASS_ARC] = {&lv_arc_class, "arc"},
+    [UI_CLASS_BAR] = {&lv_bar_class, "bar"},
+    [UI_CLASS_SLIDER] = {&lv_slider_class, "slider"},
+    [UI_CLASS_LINE] = {&lv_line_class, "line"},
+#if LV_USE_COLORWHEEL
+    [UI_CLASS_COLORWHEEL] = {&lv_colorwheel_class, "colorwheel"},
+#endif
+#if LV_USE_METER
+    [UI_CLASS_METER] = {&lv_meter_class, "meter"},
+#endif
+#if LV_USE_TABVIEW
+    [UI_CLASS_TABVIEW] = {&lv_tabview_class, "tabview"},
+#endif
+    [UI_CLASS_OTHER] = {NULL, "?"},
+};
+
+ui_class_t ui_census_get_class(const lv_obj_class_t *class_p)
+{
+    for (; class_p; class_p = class_p->base_class) {
+        for (int i = 0; i < UI_CLASS_OTHER; i++) {
+            if (class_names[i].class_p == class_p) {
+                return (ui_class_t)i;
+            }
+        }
+    }
+    return UI_CLASS_OTHER;
+}
+
+const char *ui_census_class_name(ui_class_t cls)
+{
+    return class_names[cls].name ? class_names[cls].name : "?";
+}
+
+static lv_obj_tree_walk_res_t census_cb(lv_obj_t *obj, void *user_data)
+{
+    ui_census_t *census = user_data;
+
+    uint32_t bytes = obj->class_p->instance_size;
+    if (obj->spec_attr) {
+        bytes += sizeof(_lv_obj_spec_attr_t) + obj->spec_attr->child_cnt * sizeof(lv_obj_t *);
+        census->event_dscs += obj->spec_attr->event_dsc_cnt;
+        census->event_bytes += obj->spec_attr->event_dsc_cnt * sizeof(lv_event_dsc_t);
+    }
+    ui_class_t cls = ui_census_get_class(obj->class_p);
+    if (cls == UI_CLASS_LABEL) {
+        lv_label_t *label = (lv_label_t *)obj;
+        if (label->text && !label->static_txt) {
+            bytes += strlen(label->text) + 1;
+        }
+    }
+    census->classes[cls].objs++;
+    census->classes[cls].bytes += bytes;
+    census->objs++;
+    census->obj_bytes += bytes;
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static bool in_tree(lv_obj_t *root, void *var)
+{
+    /* animations also run on plain variables, only objects are followed up to the root */
+    if (!lv_obj_is_valid(var)) {
+        return false;
+    }
+    for (lv_obj_t *obj = var; obj; obj = lv_obj_get_parent(obj)) {
+        if (obj == root) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ui_census_take(lv_obj_t *root, ui_census_t *census)
+{
+    lv_memset_00(census, sizeof(ui_census_t));
+    lv_obj_tree_walk(root, census_cb, census);
+    ui_theme_get_style_usage(root, &census->styles);
+
+    lv_anim_t *a;
+    _LV_LL_READ(&LV_GC_ROOT(_lv_anim_ll), a) {
+        if (in_tree(root, a->var)) {
+            census->anims++;
+            census->anim_bytes += sizeof(lv_anim_t);
+        }
+    }
+}
+
+void ui_census_print(const char *name, const ui_census_t *census)
+{
+    printf("%s: %u objs, %u B\n", name, census->objs, census->obj_bytes);
+    for (int i = 0; i < UI_CLASS_NUM; i++) {
+        if (census->classes[i].objs) {
+            printf("  %-10s %4u objs %6u B\n", ui_census_class_name(i), census->classes[i].objs, census->classes[i].bytes);
+        }
+    }
+    printf("  styles     %4u refs  %6u B, %u local props\n", census->styles.style_refs, census->styles.bytes,
+           census->styles.local_props);
+    printf("  events     %4u cbs   %6u B\n", census->event_dscs, census->event_bytes);
+    printf("  anims      %4u       %6u B\n", census->anims, census->anim_bytes);
+}
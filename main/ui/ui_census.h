@@ -0,0 +1,66 @@
+#ifndef UI_CENSUS_H__
+#define UI_CENSUS_H__
+
+#include "lvgl.h"
+#include "ui_theme.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UI_CLASS_OBJ,
+    UI_CLASS_LABEL,
+    UI_CLASS_IMG,
+    UI_CLASS_BTN,
+    UI_CLASS_ARC,
+    UI_CLASS_BAR,
+    UI_CLASS_SLIDER,
+    UI_CLASS_LINE,
+    UI_CLASS_COLORWHEEL,
+    UI_CLASS_METER,
+    UI_CLASS_TABVIEW,
+    UI_CLASS_OTHER,
+    UI_CLASS_NUM,
+} ui_class_t;
+
+typedef struct {
+    uint32_t objs;
+    uint32_t bytes;
+} ui_census_class_t;
+
+/* heap payload without the allocator's headers */
+typedef struct {
+    ui_census_class_t classes[UI_CLASS_NUM];
+    uint32_t objs;
+    uint32_t obj_bytes;         /* instances, special attributes, child arrays and label texts */
+    ui_theme_style_usage_t styles;
+    uint32_t event_dscs;        /* event callback entries */
+    uint32_t event_bytes;
+    uint32_t anims;             /* running animations of objects in the tree */
+    uint32_t anim_bytes;
+} ui_census_t;
+
+/**
+ * Count the objects, styles, event callbacks and animations of `root` and its children.
+ */
+void ui_census_take(lv_obj_t *root, ui_census_t *census);
+
+/**
+ * Print `census` as a table, one line per class in use.
+ */
+void ui_census_print(const char *name, const ui_census_t *census);
+
+/**
+ * @return the class of `class_p`, a derived class without an entry counts as its closest
+ *         listed base
+ */
+ui_class_t ui_census_get_class(const lv_obj_class_t *class_p);
+
+const char *ui_census_class_name(ui_class_t cls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,7 +2,9 @@
 #include <stdio.h>
 #include <time.h>
 #include "lvgl.h"
+#include "dlog.h"
 #include "ui.h"
+#include "ui_asset_pool.h"
 #include "ui_clock.h"
 
 static lv_obj_t  *page, *meter = NULL;
@@ -12,6 +14,8 @@ static lv_meter_indicator_t *indic_hour ;
 static lv_timer_t *timer;
 static ret_cb_t return_callback;
 
+DLOG_TAG_DEFINE(log_tag, "clock", 1);
+
 static void clock_handler(lv_timer_t *t)
 {
     static time_t time_last = 0;
@@ -21,7 +25,7 @@ static void clock_handler(lv_timer_t *t)
     if (now != time_last) {
         time_last = now;
         localtime_r(&now, &timeinfo);
-        printf("time=%d:%d:%d\n", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+        DLOG(&log_tag, "time=%d:%d:%d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
         lv_meter_set_indicator_end_value(meter, indic_sec, timeinfo.tm_sec);
         lv_meter_set_indicator_end_value(meter, indic_min, timeinfo.tm_min);
         if (timeinfo.tm_hour > 12) {
@@ -87,10 +91,13 @@ void ui_clock_init(ret_cb_t ret_cb)
     LV_IMG_DECLARE(img_needle_hour);
     LV_IMG_DECLARE(img_needle_min);
     LV_IMG_DECLARE(img_needle_sec);
+    /*The needles are rotated every second, keep them out of the flash cache*/
+    static const lv_img_dsc_t *const hot_assets[] = {&img_needle_sec, &img_needle_min, &img_needle_hour};
+    ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
     /*Add a the hands from images*/
-    indic_hour = lv_meter_add_needle_img(meter, scale_hour, &img_needle_hour, 5, 15);
-    indic_min = lv_meter_add_needle_img(meter, scale_min, &img_needle_min, 4, 15);
-    indic_sec = lv_meter_add_needle_img(meter, scale_min, &img_needle_sec, 5, 15); // second needle on the top
+    indic_hour = lv_meter_add_needle_img(meter, scale_hour, ui_asset_pool_get(&img_needle_hour), 5, 15);
+    indic_min = lv_meter_add_needle_img(meter, scale_min, ui_asset_pool_get(&img_needle_min), 4, 15);
+    indic_sec = lv_meter_add_needle_img(meter, scale_min, ui_asset_pool_get(&img_needle_sec), 5, 15); // second needle on the top
 
     timer = lv_timer_create(clock_handler, 200, NULL);
     clock_handler(timer);
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include "lvgl.h"
+#include "ui_coalesce.h"
+
+#define PENDING_MAX     (8)
+
+typedef struct {
+    lv_obj_t *obj;
+    bool pending;
+    bool dispatching;
+    uint32_t elided;
+} coalesce_t;
+
+static coalesce_t *pending[PENDING_MAX];
+static uint8_t pending_cnt;
+static lv_timer_t *dispatch_timer;
+static uint32_t elided_total;
+
+static void deliver(coalesce_t *c)
+{
+    c->dispatching = true;
+    if (lv_event_send(c->obj, LV_EVENT_VALUE_CHANGED, NULL) == LV_RES_OK) {
+        c->dispatching = false;
+    }
+}
+
+/**
+ * One-shot timer with period 0: new timers go to the head of the timer list, so it runs in
+ * the same lv_timer_handler() pass that produced the changes, before the next refresh.
+ */
+static void dispatch_timer_cb(lv_timer_t *t)
+{
+    dispatch_timer = NULL;
+    /* pop one at a time, a handler may delete objects that are still queued */
+    while (pending_cnt) {
+        coalesce_t *c = pending[0];
+        pending[0] = pending[--pending_cnt];
+        c->pending = false;
+        deliver(c);
+    }
+}
+
+static void unqueue(coalesce_t *c)
+{
+    for (uint8_t i = 0; i < pending_cnt; i++) {
+        if (pending[i] == c) {
+            pending[i] = pending[--pending_cnt];
+            return;
+        }
+    }
+}
+
+static void coalesce_event_cb(lv_event_t *e)
+{
+    coalesce_t *c = lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (LV_EVENT_DELETE == code) {
+        unqueue(c);
+        lv_mem_free(c);
+        return;
+    }
+    if (c->dispatching) {
+        return;
+    }
+
+    /* keep the raw change from the handlers added after this one */
+    lv_event_stop_processing(e);
+    if (c->pending) {
+        c->elided++;
+        elided_total++;
+        return;
+    }
+    if (pending_cnt == PENDING_MAX) {
+        /* nothing to merge with, deliver right away */
+        deliver(c);
+        return;
+    }
+    c->pending = true;
+    pending[pending_cnt++] = c;
+    if (!dispatch_timer) {
+        dispatch_timer = lv_timer_create(dispatch_timer_cb, 0, NULL);
+        lv_timer_set_repeat_count(dispatch_timer, 1);
+    }
+}
+
+void ui_coalesce_value_changed(lv_obj_t *obj, lv_event_cb_t event_cb, void *user_data)
+{
+    coalesce_t *c = lv_obj_get_event_user_data(obj, coalesce_event_cb);
+    if (!c) {
+        c = lv_mem_alloc(sizeof(coalesce_t));
+        LV_ASSERT_MALLOC(c);
+        lv_memset_00(c, sizeof(coalesce_t));
+        c->obj = obj;
+        /* in front of every value handler of `obj` */
+        lv_obj_add_event_cb(obj, coalesce_event_cb, LV_EVENT_VALUE_CHANGED, c);
+        lv_obj_add_event_cb(obj, coalesce_event_cb, LV_EVENT_DELETE, c);
+    }
+    lv_obj_add_event_cb(obj, event_cb, LV_EVENT_VALUE_CHANGED, user_data);
+}
+
+uint32_t ui_coalesce_get_elided(lv_obj_t *obj)
+{
+    if (!obj) {
+        return elided_total;
+    }
+    coalesce_t *c = lv_obj_get_event_user_data(obj, coalesce_event_cb);
+    return c ? c->elided : 0;
+}
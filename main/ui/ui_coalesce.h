@@ -0,0 +1,26 @@
+#ifndef UI_COALESCE_H__
+#define UI_COALESCE_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Add `event_cb` for LV_EVENT_VALUE_CHANGED of `obj`, but coalesced: however many changes
+ * happen before the next frame (e.g. one per detent of a fast encoder spin), `event_cb` runs
+ * once with the widget already at its final value.
+ */
+void ui_coalesce_value_changed(lv_obj_t *obj, lv_event_cb_t event_cb, void *user_data);
+
+/**
+ * @return the intermediate changes of `obj` that were dropped, of all objects if NULL
+ */
+uint32_t ui_coalesce_get_elided(lv_obj_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
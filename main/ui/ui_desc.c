@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "dlog.h"
+#include "ui_desc.h"
+#include "ui_digits.h"
+
+#define UI_DESC_MAX_OBJS    (32)
+
+DLOG_TAG_DEFINE(log_tag, "ui_desc", 4);
+
+static lv_obj_t *create_obj(const ui_desc_obj_t *d, lv_obj_t *parent)
+{
+    lv_obj_t *obj;
+
+    switch (d->type) {
+    case UI_DESC_LABEL:
+        obj = lv_label_create(parent);
+        if (d->text) {
+            lv_label_set_text_static(obj, d->text);
+        }
+        break;
+    case UI_DESC_IMG:
+        obj = lv_img_create(parent);
+        if (d->src) {
+            lv_img_set_src(obj, d->src);
+        }
+        break;
+    case UI_DESC_ARC:
+        obj = lv_arc_create(parent);
+        if (d->arc) {
+            lv_arc_set_rotation(obj, d->arc->rotation);
+            lv_arc_set_bg_angles(obj, d->arc->bg_start, d->arc->bg_end);
+            if (d->arc->min != d->arc->max) {
+                lv_arc_set_range(obj, d->arc->min, d->arc->max);
+            }
+            lv_arc_set_value(obj, d->arc->value);
+        }
+        break;
+    case UI_DESC_BTN:
+        obj = lv_btn_create(parent);
+        break;
+    case UI_DESC_DIGITS:
+        obj = ui_digits_create(parent, d->digits->font, d->digits->charset, d->digits->cells);
+        if (d->text) {
+            ui_digits_set_text(obj, d->text);
+        }
+        break;
+    default:
+        obj = lv_obj_create(parent);
+        break;
+    }
+    return obj;
+}
+
+static void start_intro_anim(lv_obj_t *obj, const ui_desc_obj_t *d)
+{
+    lv_coord_t y = lv_obj_get_y_aligned(obj);
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, obj);
+    lv_anim_set_delay(&a, d->anim_delay);
+    lv_anim_set_values(&a, y + d->anim_dy, y);
+    lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_y);
+    lv_anim_set_path_cb(&a, lv_anim_path_overshoot);
+    lv_anim_set_time(&a, d->anim_time);
+    lv_anim_start(&a);
+}
+
+void ui_desc_build_begin(ui_desc_builder_t *b, lv_obj_t *root, const ui_desc_obj_t *desc, size_t count,
+                         lv_obj_t **objs)
+{
+    LV_ASSERT(count <= UI_DESC_MAX_OBJS);
+    b->root = root;
+    b->desc = desc;
+    b->count = count;
+    b->next = 0;
+    b->objs = objs;
+    b->build_us = 0;
+}
+
+bool ui_desc_build_step(ui_desc_builder_t *b)
+{
+    if (b->next == b->count) {
+        return true;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    size_t i = b->next++;
+    const ui_desc_obj_t *d = &b->desc[i];
+    LV_ASSERT(d->parent < (int)i && d->align_to < (int)i);
+    lv_obj_t *parent = (d->parent < 0) ? b->root : b->objs[d->parent];
+    /* joining the encoder group waits for the finish, the group may still belong to another screen */
+    lv_group_t *group = lv_group_get_default();
+    lv_group_set_default(NULL);
+    lv_obj_t *obj = create_obj(d, parent);
+    lv_group_set_default(group);
+    b->objs[i] = obj;
+    if (i == 0) {
+        /* nothing is drawn or invalidated until the build is finished */
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    if (d->size_mode == UI_DESC_SIZE_PARENT) {
+        lv_obj_set_size(obj, lv_obj_get_width(parent) - d->w, lv_obj_get_height(parent) - d->h);
+    } else {
+        if (d->w) {
+            lv_obj_set_width(obj, d->w);
+        }
+        if (d->h) {
+            lv_obj_set_height(obj, d->h);
+        }
+    }
+    if (d->remove_style) {
+        lv_obj_remove_style(obj, NULL, d->remove_style);
+    }
+    for (uint8_t k = 0; k < d->style_cnt; k++) {
+        lv_obj_set_local_style_prop(obj, d->styles[k].prop, d->styles[k].value, d->styles[k].selector);
+    }
+    if (d->clear_flags) {
+        lv_obj_clear_flag(obj, d->clear_flags);
+    }
+    if (d->align != LV_ALIGN_DEFAULT) {
+        if (d->align_to < 0) {
+            lv_obj_align(obj, d->align, d->x_ofs, d->y_ofs);
+        } else {
+            lv_obj_align_to(obj, b->objs[d->align_to], d->align, d->x_ofs, d->y_ofs);
+        }
+    }
+    b->build_us += esp_timer_get_time() - t0;
+    return b->next == b->count;
+}
+
+lv_obj_t *ui_desc_build_finish(ui_desc_builder_t *b)
+{
+    while (!ui_desc_build_step(b)) {
+    }
+    if (!b->count) {
+        return NULL;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    lv_group_t *group = lv_group_get_default();
+    for (size_t i = 0; group && i < b->count; i++) {
+        if (lv_obj_is_group_def(b->objs[i])) {
+            lv_group_add_obj(group, b->objs[i]);
+        }
+    }
+    lv_obj_clear_flag(b->objs[0], LV_OBJ_FLAG_HIDDEN);
+    /* animations start from the final aligned positions, like the hand written screens did */
+    for (size_t i = 0; i < b->count; i++) {
+        if (b->desc[i].anim_time) {
+            start_intro_anim(b->objs[i], &b->desc[i]);
+        }
+    }
+    b->build_us += esp_timer_get_time() - t0;
+    /* the hand written screens this replaced can be timed the same way around their init */
+    DLOG(&log_tag, "%u objects built in %u us", b->count, b->build_us);
+    return b->objs[0];
+}
+
+lv_obj_t *ui_desc_build(lv_obj_t *root, const ui_desc_obj_t *desc, size_t count, lv_obj_t **out)
+{
+    lv_obj_t *objs[UI_DESC_MAX_OBJS];
+    ui_desc_builder_t b;
+
+    ui_desc_build_begin(&b, root, desc, count, out ? out : objs);
+    return ui_desc_build_finish(&b);
+}
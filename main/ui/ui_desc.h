@@ -0,0 +1,117 @@
+#ifndef UI_DESC_H__
+#define UI_DESC_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UI_DESC_OBJ,
+    UI_DESC_LABEL,
+    UI_DESC_IMG,
+    UI_DESC_ARC,
+    UI_DESC_BTN,
+    UI_DESC_DIGITS,
+} ui_desc_type_t;
+
+typedef enum {
+    UI_DESC_SIZE_ABS,       /* w/h as given, 0 keeps the default */
+    UI_DESC_SIZE_PARENT,    /* parent size minus w/h */
+} ui_desc_size_mode_t;
+
+typedef struct {
+    lv_style_prop_t prop;
+    lv_style_value_t value;
+    lv_style_selector_t selector;
+} ui_desc_style_t;
+
+typedef struct {
+    int16_t rotation;
+    uint16_t bg_start;
+    uint16_t bg_end;
+    int16_t min;
+    int16_t max;
+    int16_t value;
+} ui_desc_arc_t;
+
+typedef struct {
+    const lv_font_t *font;
+    const char *charset;
+    uint8_t cells;
+} ui_desc_digits_t;
+
+/**
+ * One object of a screen. Objects are created in table order, `parent` and `align_to` are
+ * indexes of earlier entries (-1 for the given root / the parent).
+ */
+typedef struct {
+    uint8_t type;
+    int8_t parent;
+    int8_t align_to;
+    uint8_t align;                      /* LV_ALIGN_DEFAULT leaves the position alone */
+    lv_coord_t x_ofs;
+    lv_coord_t y_ofs;
+    uint8_t size_mode;
+    lv_coord_t w;
+    lv_coord_t h;
+    const char *text;                   /* UI_DESC_LABEL, UI_DESC_DIGITS */
+    const void *src;                    /* UI_DESC_IMG */
+    const ui_desc_arc_t *arc;           /* UI_DESC_ARC */
+    const ui_desc_digits_t *digits;     /* UI_DESC_DIGITS */
+    const ui_desc_style_t *styles;
+    uint8_t style_cnt;
+    lv_style_selector_t remove_style;   /* drop all styles of this part first, 0 for none */
+    lv_obj_flag_t clear_flags;
+    /* intro animation: y slides from its aligned position + anim_dy back with overshoot */
+    int16_t anim_dy;
+    uint16_t anim_time;
+    uint16_t anim_delay;
+} ui_desc_obj_t;
+
+#define UI_DESC_STYLES(s)   .styles = (s), .style_cnt = sizeof(s) / sizeof((s)[0])
+#define UI_DESC_NUM(p, v, sel)      {(p), {.num = (v)}, (sel)}
+#define UI_DESC_PTR(p, v, sel)      {(p), {.ptr = (v)}, (sel)}
+#define UI_DESC_COLOR(p, v, sel)    {(p), {.color = v}, (sel)}
+
+/**
+ * Build `count` objects under `root` in one pass and start their intro animations.
+ * @param out optional, receives the created object of every entry
+ * @return the object of the first entry
+ */
+lv_obj_t *ui_desc_build(lv_obj_t *root, const ui_desc_obj_t *desc, size_t count, lv_obj_t **out);
+
+/**
+ * Build a screen a few objects at a time, e.g. while something else is animating.
+ * The first object stays hidden until ui_desc_build_finish().
+ */
+typedef struct {
+    lv_obj_t *root;
+    const ui_desc_obj_t *desc;
+    size_t count;
+    size_t next;
+    lv_obj_t **objs;        /* `count` entries, owned by the caller */
+    uint32_t build_us;      /* spent in the steps and the finish, logged by the finish */
+} ui_desc_builder_t;
+
+void ui_desc_build_begin(ui_desc_builder_t *b, lv_obj_t *root, const ui_desc_obj_t *desc, size_t count,
+                         lv_obj_t **objs);
+
+/**
+ * Create the next object.
+ * @return true once every object exists
+ */
+bool ui_desc_build_step(ui_desc_builder_t *b);
+
+/**
+ * Create what's left, show the screen and start the intro animations.
+ * @return the object of the first entry
+ */
+lv_obj_t *ui_desc_build_finish(ui_desc_builder_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
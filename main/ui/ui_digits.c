@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui_digits.h"
+
+#define SPRITE_SETS         (6)
+#define SPRITE_MAX_GLYPHS   (16)
+
+typedef struct {
+    const lv_font_t *font;
+    const char *charset;
+    uint16_t digit_w;
+    uint8_t count;
+    uint32_t letters[SPRITE_MAX_GLYPHS];
+    lv_img_dsc_t sprites[SPRITE_MAX_GLYPHS];
+} sprite_set_t;
+
+typedef struct {
+    const sprite_set_t *set;
+    uint8_t cells;
+    uint8_t len;
+    uint32_t shown[UI_DIGITS_MAX_CELLS];
+    lv_coord_t x[UI_DIGITS_MAX_CELLS];
+    lv_obj_t *img[UI_DIGITS_MAX_CELLS];
+    ui_digits_stats_t stats;
+} ui_digits_t;
+
+static sprite_set_t sets[SPRITE_SETS];
+
+static bool is_digit(uint32_t letter)
+{
+    return letter >= '0' && letter <= '9';
+}
+
+static uint8_t glyph_alpha(const uint8_t *bitmap, uint32_t i, uint8_t bpp)
+{
+    /* glyph bitmaps are packed MSB first without row padding */
+    uint32_t bit = i * bpp;
+    uint8_t v = (bitmap[bit >> 3] >> (8 - bpp - (bit & 0x7))) & ((1 << bpp) - 1);
+    switch (bpp) {
+    case 1: return v ? 0xff : 0;
+    case 2: return v * 85;
+    case 4: return v * 17;
+    default: return v;
+    }
+}
+
+static bool sprite_render(const lv_font_t *font, uint32_t letter, lv_coord_t w, lv_img_dsc_t *dsc)
+{
+    lv_font_glyph_dsc_t g;
+    lv_coord_t h = lv_font_get_line_height(font);
+    if (!lv_font_get_glyph_dsc(font, &g, letter, 0)) {
+        return false;
+    }
+    if (!w) {
+        w = g.adv_w;
+    }
+
+    uint8_t *data = calloc(1, w * h);
+    if (!data) {
+        return false;
+    }
+    const uint8_t *bitmap = g.box_w ? lv_font_get_glyph_bitmap(g.resolved_font, letter) : NULL;
+    /* same placement as lv_draw_letter(), narrower digits are centred in the digit width */
+    lv_coord_t x0 = g.ofs_x + (w - g.adv_w) / 2;
+    lv_coord_t y0 = (font->line_height - font->base_line) - g.box_h - g.ofs_y;
+    for (lv_coord_t y = 0; bitmap && y < g.box_h; y++) {
+        for (lv_coord_t x = 0; x < g.box_w; x++) {
+            lv_coord_t px = x0 + x, py = y0 + y;
+            if (px >= 0 && px < w && py >= 0 && py < h) {
+                data[py * w + px] = glyph_alpha(bitmap, y * g.box_w + x, g.bpp);
+            }
+        }
+    }
+
+    dsc->header.always_zero = 0;
+    dsc->header.cf = LV_IMG_CF_ALPHA_8BIT;
+    dsc->header.w = w;
+    dsc->header.h = h;
+    dsc->data_size = w * h;
+    dsc->data = data;
+    return true;
+}
+
+static const sprite_set_t *sprite_set_get(const lv_font_t *font, const char *charset)
+{
+    sprite_set_t *set = NULL;
+    for (int i = 0; i < SPRITE_SETS; i++) {
+        if (sets[i].font == font && sets[i].charset == charset) {
+            return &sets[i];
+        }
+        if (!set && !sets[i].font) {
+            set = &sets[i];
+        }
+    }
+    if (!set) {
+        LV_LOG_WARN("no free sprite set");
+        return NULL;
+    }
+
+    set->font = font;
+    set->charset = charset;
+    for (uint32_t c = '0'; c <= '9'; c++) {
+        lv_font_glyph_dsc_t g;
+        if (lv_font_get_glyph_dsc(font, &g, c, 0)) {
+            set->digit_w = LV_MAX(set->digit_w, g.adv_w);
+        }
+    }
+
+    uint32_t i = 0;
+    while (charset[i] && set->count < SPRITE_MAX_GLYPHS) {
+        uint32_t letter = _lv_txt_encoded_next(charset, &i);
+        lv_img_dsc_t *dsc = &set->sprites[set->count];
+        if (sprite_render(font, letter, is_digit(letter) ? set->digit_w : 0, dsc)) {
+            set->letters[set->count++] = letter;
+        }
+    }
+    return set;
+}
+
+static const lv_img_dsc_t *sprite_find(const sprite_set_t *set, uint32_t letter)
+{
+    for (int i = 0; i < set->count; i++) {
+        if (set->letters[i] == letter) {
+            return &set->sprites[i];
+        }
+    }
+    return NULL;
+}
+
+static void delete_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_mem_free(lv_obj_get_user_data(obj));
+    lv_obj_set_user_data(obj, NULL);
+}
+
+lv_obj_t *ui_digits_create(lv_obj_t *parent, const lv_font_t *font, const char *charset, uint8_t cells)
+{
+    const sprite_set_t *set = sprite_set_get(font, charset);
+    ui_digits_t *d = lv_mem_alloc(sizeof(ui_digits_t));
+    LV_ASSERT_MALLOC(d);
+    lv_memset_00(d, sizeof(ui_digits_t));
+    d->set = set;
+    d->cells = LV_MIN(cells, UI_DIGITS_MAX_CELLS);
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(obj, set ? set->digit_w * d->cells : 0, lv_font_get_line_height(font));
+    lv_obj_set_user_data(obj, d);
+    lv_obj_add_event_cb(obj, delete_event_cb, LV_EVENT_DELETE, NULL);
+
+    lv_color_t color = lv_obj_get_style_text_color(parent, LV_PART_MAIN);
+    for (int i = 0; i < d->cells; i++) {
+        d->img[i] = lv_img_create(obj);
+        lv_obj_add_flag(d->img[i], LV_OBJ_FLAG_HIDDEN);
+        /* alpha only sprites take their colour from the recolor style */
+        lv_obj_set_style_img_recolor(d->img[i], color, 0);
+        lv_obj_set_style_img_recolor_opa(d->img[i], LV_OPA_COVER, 0);
+    }
+    return obj;
+}
+
+void ui_digits_set_text(lv_obj_t *obj, const char *text)
+{
+    ui_digits_t *d = lv_obj_get_user_data(obj);
+    if (!d || !d->set) {
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+
+    uint32_t letters[UI_DIGITS_MAX_CELLS];
+    const lv_img_dsc_t *src[UI_DIGITS_MAX_CELLS];
+    lv_coord_t total = 0;
+    uint32_t i = 0;
+    uint8_t len = 0;
+    while (text[i] && len < d->cells) {
+        letters[len] = _lv_txt_encoded_next(text, &i);
+        src[len] = sprite_find(d->set, letters[len]);
+        total += src[len] ? src[len]->header.w : d->set->digit_w;
+        len++;
+    }
+
+    lv_coord_t x = (lv_obj_get_width(obj) - total) / 2;
+    lv_coord_t h = lv_obj_get_height(obj);
+    uint32_t changed = 0;
+    for (int k = 0; k < d->cells; k++) {
+        uint32_t letter = (k < len) ? letters[k] : 0;
+        const lv_img_dsc_t *s = (k < len) ? src[k] : NULL;
+        bool moved = (k < len) && d->x[k] != x;
+        if (letter == d->shown[k] && !moved) {
+            x += s ? s->header.w : d->set->digit_w;
+            continue;
+        }
+
+        lv_obj_t *img = d->img[k];
+        if (s) {
+            lv_img_set_src(img, s);
+            lv_obj_clear_flag(img, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+        }
+        if (moved) {
+            lv_obj_set_x(img, x);
+            d->x[k] = x;
+        }
+        d->shown[k] = letter;
+        d->stats.inv_px += (s ? s->header.w : d->set->digit_w) * h;
+        changed++;
+        x += s ? s->header.w : d->set->digit_w;
+    }
+    d->len = len;
+
+    uint32_t us = esp_timer_get_time() - start;
+    d->stats.updates++;
+    d->stats.cells_changed += changed;
+    d->stats.last_us = us;
+    d->stats.max_us = LV_MAX(d->stats.max_us, us);
+}
+
+void ui_digits_set_value(lv_obj_t *obj, int32_t value)
+{
+    char buf[12];
+    lv_snprintf(buf, sizeof(buf), "%d", (int)value);
+    ui_digits_set_text(obj, buf);
+}
+
+void ui_digits_set_color(lv_obj_t *obj, lv_color_t color)
+{
+    ui_digits_t *d = lv_obj_get_user_data(obj);
+    for (int i = 0; d && i < d->cells; i++) {
+        lv_obj_set_style_img_recolor(d->img[i], color, 0);
+    }
+}
+
+void ui_digits_get_stats(lv_obj_t *obj, ui_digits_stats_t *stats)
+{
+    ui_digits_t *d = lv_obj_get_user_data(obj);
+    if (d) {
+        *stats = d->stats;
+    } else {
+        lv_memset_00(stats, sizeof(ui_digits_stats_t));
+    }
+}
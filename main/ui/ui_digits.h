@@ -0,0 +1,36 @@
+#ifndef UI_DIGITS_H__
+#define UI_DIGITS_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UI_DIGITS_MAX_CELLS     (16)
+
+typedef struct {
+    uint32_t updates;
+    uint32_t cells_changed;
+    uint32_t inv_px;        /* area of the cells invalidated by the updates */
+    uint32_t last_us;       /* CPU time of the last update, rendering not included */
+    uint32_t max_us;
+} ui_digits_stats_t;
+
+/**
+ * Numeric readout drawn from pre-rasterized glyph sprites of `font`. Only the characters of
+ * `charset` (UTF-8) can be shown, others are left blank. Digits share one width so changing a
+ * value only redraws the cells whose digit changed; the text is centred in `cells` digit widths.
+ * The sprites of a font/charset pair are built once and shared by all readouts using it.
+ */
+lv_obj_t *ui_digits_create(lv_obj_t *parent, const lv_font_t *font, const char *charset, uint8_t cells);
+void ui_digits_set_text(lv_obj_t *obj, const char *text);
+void ui_digits_set_value(lv_obj_t *obj, int32_t value);
+void ui_digits_set_color(lv_obj_t *obj, lv_color_t color);
+void ui_digits_get_stats(lv_obj_t *obj, ui_digits_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,10 +3,17 @@
 #include <time.h>
 #include "lvgl.h"
 #include "ui.h"
+#include "dev_state.h"
+#include "ui_coalesce.h"
+#include "ui_desc.h"
+#include "ui_digits.h"
 #include "ui_fan.h"
+#include "ui_state.h"
 
-static lv_obj_t  *page;
+static lv_obj_t *page;
 static ret_cb_t return_callback;
+static ui_desc_builder_t builder;
+static bool preloading;
 
 
 
@@ -26,6 +33,85 @@ static void fan_event_cb(lv_event_t *e)
     }
 }
 
+static void speed_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_obj_t *value = lv_event_get_user_data(e);
+
+    ui_digits_set_value(value, lv_arc_get_value(obj));
+}
+
+LV_FONT_DECLARE(font_cn_32);
+
+enum {
+    OBJ_PAGE,
+    OBJ_ARC,
+    OBJ_TITLE,
+    OBJ_UNIT,
+    OBJ_VALUE,
+    OBJ_NUM,
+};
+
+static const ui_desc_style_t page_styles[] = {
+    UI_DESC_NUM(LV_STYLE_BORDER_WIDTH, 0, 0),
+    UI_DESC_NUM(LV_STYLE_RADIUS, 0, 0),
+};
+
+static const ui_desc_style_t arc_styles[] = {
+    UI_DESC_NUM(LV_STYLE_ARC_WIDTH, 20, LV_PART_MAIN),
+    UI_DESC_NUM(LV_STYLE_ARC_WIDTH, 20, LV_PART_INDICATOR),
+    UI_DESC_COLOR(LV_STYLE_ARC_COLOR, LV_COLOR_MAKE(60, 60, 60), LV_PART_MAIN),
+    UI_DESC_COLOR(LV_STYLE_ARC_COLOR, LV_COLOR_MAKE(20, 70, 200), LV_PART_INDICATOR),
+    /* lv_palette_main() light blue and yellow, the knob itself has no styles left to draw */
+    UI_DESC_NUM(LV_STYLE_OUTLINE_WIDTH, 2, LV_STATE_FOCUSED | LV_PART_KNOB),
+    UI_DESC_COLOR(LV_STYLE_OUTLINE_COLOR, LV_COLOR_MAKE(0x03, 0xA9, 0xF4), LV_STATE_FOCUSED | LV_PART_KNOB),
+    UI_DESC_COLOR(LV_STYLE_OUTLINE_COLOR, LV_COLOR_MAKE(0xFF, 0xEB, 0x3B), LV_STATE_EDITED | LV_PART_KNOB),
+};
+
+static const ui_desc_arc_t arc_cfg = {
+    .rotation = 180, .bg_start = 0, .bg_end = 180, .value = 30,
+};
+
+static const ui_desc_style_t title_styles[] = {
+    UI_DESC_PTR(LV_STYLE_TEXT_FONT, &font_cn_32, 0),
+    UI_DESC_NUM(LV_STYLE_TEXT_ALIGN, LV_TEXT_ALIGN_CENTER, 0),
+};
+
+static const ui_desc_style_t unit_styles[] = {
+    UI_DESC_PTR(LV_STYLE_TEXT_FONT, &lv_font_montserrat_20, 0),
+    UI_DESC_NUM(LV_STYLE_TEXT_ALIGN, LV_TEXT_ALIGN_CENTER, 0),
+};
+
+static const ui_desc_digits_t value_digits = {
+    .font = &lv_font_montserrat_40, .charset = "0123456789", .cells = 3,
+};
+
+static lv_obj_t *objs[OBJ_NUM];
+
+static const ui_desc_obj_t fan_desc[OBJ_NUM] = {
+    [OBJ_PAGE] = {
+        .type = UI_DESC_OBJ, .parent = -1, .align_to = -1, .align = LV_ALIGN_CENTER,
+        .size_mode = UI_DESC_SIZE_PARENT, UI_DESC_STYLES(page_styles), .clear_flags = LV_OBJ_FLAG_SCROLLABLE,
+    },
+    [OBJ_ARC] = {
+        .type = UI_DESC_ARC, .parent = OBJ_PAGE, .align_to = -1, .align = LV_ALIGN_CENTER,
+        .size_mode = UI_DESC_SIZE_PARENT, .w = 15, .h = 15, .arc = &arc_cfg,
+        UI_DESC_STYLES(arc_styles), .remove_style = LV_PART_KNOB,
+    },
+    [OBJ_TITLE] = {
+        .type = UI_DESC_LABEL, .parent = OBJ_PAGE, .align_to = -1, .align = LV_ALIGN_CENTER, .y_ofs = -60,
+        .w = 150, .text = "Fan", UI_DESC_STYLES(title_styles),
+    },
+    [OBJ_UNIT] = {
+        .type = UI_DESC_LABEL, .parent = OBJ_PAGE, .align_to = -1, .align = LV_ALIGN_CENTER, .x_ofs = 40, .y_ofs = -10,
+        .w = 50, .text = "%", UI_DESC_STYLES(unit_styles),
+    },
+    [OBJ_VALUE] = {
+        .type = UI_DESC_DIGITS, .parent = OBJ_PAGE, .align_to = -1, .align = LV_ALIGN_CENTER,
+        .digits = &value_digits,
+    },
+};
+
 void ui_fan_init(ret_cb_t ret_cb)
 {
     if (page) {
@@ -35,58 +121,43 @@ void ui_fan_init(ret_cb_t ret_cb)
 
     return_callback = ret_cb;
 
-    page = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(page, lv_obj_get_width(lv_obj_get_parent(page)), lv_obj_get_height(lv_obj_get_parent(page)));
-    lv_obj_set_style_border_width(page, 0, 0);
-    lv_obj_set_style_radius(page, 0, 0);
-    lv_obj_clear_flag(page, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_center(page);
-
-    lv_obj_t *arc = lv_arc_create(page);
-    lv_obj_set_size(arc, lv_obj_get_width(page) - 15, lv_obj_get_height(page) - 15);
-    lv_arc_set_rotation(arc, 180);
-    lv_arc_set_bg_angles(arc, 0, 180);
-    // lv_arc_set_angles(arc, 0, 30);
-    lv_arc_set_value(arc, 30);
-    // lv_arc_set_range(arc, 0, 100);
-    lv_obj_set_style_arc_width(arc, 20, LV_PART_MAIN);
-    lv_obj_set_style_arc_width(arc, 20, LV_PART_INDICATOR);
-    lv_obj_set_style_arc_color(arc, lv_color_make(60, 60, 60), LV_PART_MAIN);
-    lv_obj_set_style_arc_color(arc, lv_color_make(20, 70, 200), LV_PART_INDICATOR);
-    lv_obj_set_style_outline_width(arc, 2, LV_STATE_FOCUSED | LV_PART_KNOB);
-    lv_obj_set_style_outline_color(arc, lv_palette_main(LV_PALETTE_LIGHT_BLUE), LV_STATE_FOCUSED | LV_PART_KNOB);
-    lv_obj_set_style_outline_color(arc, lv_palette_main(LV_PALETTE_YELLOW), LV_STATE_EDITED | LV_PART_KNOB);
-    lv_obj_remove_style(arc, NULL, LV_PART_KNOB);   /*Be sure the knob is not displayed*/
-    // lv_obj_clear_flag(arc, LV_OBJ_FLAG_CLICKABLE);  /*To not allow adjusting by click*/
-    lv_obj_center(arc);
-
-    lv_obj_t *label1 = lv_label_create(page);
-    LV_FONT_DECLARE(font_cn_32);
-    lv_obj_set_style_text_font(label1, &font_cn_32, 0);
-    lv_label_set_text(label1, "Fan");
-    lv_obj_set_width(label1, 150);  /*Set smaller width to make the lines wrap*/
-    lv_obj_set_style_text_align(label1, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align(label1, LV_ALIGN_CENTER, 0, -60);
-
-    lv_obj_t *label2 = lv_label_create(page);
-    lv_label_set_text(label2, "%");
-    lv_obj_set_style_text_font(label2, &lv_font_montserrat_20, 0);
-    lv_obj_set_width(label2, 50);
-    lv_obj_set_style_text_align(label2, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align(label2, LV_ALIGN_CENTER, 40, -10);
-
-    lv_obj_t *label3 = lv_label_create(page);
-    lv_label_set_text_fmt(label3, "%d", lv_arc_get_value(arc));
-    lv_obj_set_style_text_font(label3, &lv_font_montserrat_40, 0);
-    lv_obj_set_width(label3, 150);  /*Set smaller width to make the lines wrap*/
-    lv_obj_set_style_text_align(label3, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align(label3, LV_ALIGN_CENTER, 0, 0);
+    if (!preloading) {
+        ui_desc_build_begin(&builder, lv_scr_act(), fan_desc, OBJ_NUM, objs);
+    }
+    preloading = false;
+    page = ui_desc_build_finish(&builder);
+    lv_arc_set_value(objs[OBJ_ARC], dev_state_get(DEV_STATE_FAN_SPEED));
+    ui_digits_set_value(objs[OBJ_VALUE], lv_arc_get_value(objs[OBJ_ARC]));
+    ui_coalesce_value_changed(objs[OBJ_ARC], speed_event_cb, objs[OBJ_VALUE]);
+    ui_state_bind_value(objs[OBJ_ARC], DEV_STATE_FAN_SPEED);
 
     lv_obj_add_event_cb(page, fan_event_cb, LV_EVENT_FOCUSED, NULL);
     lv_obj_add_event_cb(page, fan_event_cb, LV_EVENT_LONG_PRESSED, NULL);
     ui_add_obj_to_encoder_group(page);
 }
 
+bool ui_fan_preload(void)
+{
+    if (page) {
+        return true;
+    }
+    if (!preloading) {
+        ui_desc_build_begin(&builder, lv_scr_act(), fan_desc, OBJ_NUM, objs);
+        preloading = true;
+    }
+    return ui_desc_build_step(&builder);
+}
+
+void ui_fan_discard(void)
+{
+    if (preloading) {
+        preloading = false;
+        if (builder.next) {
+            lv_obj_del(objs[0]);
+        }
+    }
+}
+
 void ui_fan_delete(void)
 {
     if (page) {
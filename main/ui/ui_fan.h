@@ -8,6 +8,17 @@ extern "C" {
 void ui_fan_init(ret_cb_t ret_cb);
 void ui_fan_delete(void);
 
+/**
+ * Build the page hidden, one object per call, so that ui_fan_init() only has to show it.
+ * @return true once the page is complete
+ */
+bool ui_fan_preload(void);
+
+/**
+ * Drop a page built by ui_fan_preload() that won't be shown.
+ */
+void ui_fan_discard(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "lvgl.h"
+#include "dlog.h"
+#include "ui_asset_pool.h"
+#include "ui_img_runs.h"
+
+#define ASSET_MAX       (12)
+#define RUN_SKIP        (0)
+#define RUN_COPY        (1)
+#define RUN_BLEND       (2)
+#define RUN_TYPE(r)     ((r) >> 14)
+#define RUN_LEN(r)      ((r) & 0x3fff)
+#define RUN_MAX_LEN     (0x3fff)
+
+typedef struct {
+    uint32_t color;     /* first entry of the row in colors */
+    uint32_t alpha;     /* first entry of the row in alphas */
+    uint32_t run;       /* first entry of the row in runs, the next row's ends it */
+} row_t;
+
+/**
+ * One block: rows[h + 1] | runs | colors | alphas. Runs are (type << 14) | length, colors
+ * hold every opaque and edge pixel in order, alphas only the edge pixels.
+ */
+typedef struct {
+    const lv_img_dsc_t *src;
+    uint32_t bytes;
+    const row_t *rows;
+    const uint16_t *runs;
+    const lv_color_t *colors;
+    const lv_opa_t *alphas;
+} asset_t;
+
+DLOG_TAG_DEFINE(log_tag, "img_runs", 20);
+
+static asset_t assets[ASSET_MAX];
+static uint32_t budget;
+static ui_img_runs_stats_t stats;
+
+static uint8_t px_type(lv_opa_t a)
+{
+    /* same cut-offs as the blenders */
+    return (a <= LV_OPA_MIN) ? RUN_SKIP : (a >= LV_OPA_MAX) ? RUN_COPY : RUN_BLEND;
+}
+
+static asset_t *find(const lv_img_dsc_t *src)
+{
+    for (int i = 0; i < ASSET_MAX; i++) {
+        if (assets[i].src == src) {
+            return &assets[i];
+        }
+    }
+    return NULL;
+}
+
+void ui_img_runs_init(uint32_t budget_bytes)
+{
+    lv_memset_00(assets, sizeof(assets));
+    lv_memset_00(&stats, sizeof(stats));
+    budget = budget_bytes;
+}
+
+bool ui_img_runs_encode(const lv_img_dsc_t *src, const char *name)
+{
+    if (find(src)) {
+        return true;
+    }
+    asset_t *a = find(NULL);
+    if (!a || src->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA) {
+        stats.rejected++;
+        return false;
+    }
+
+    uint16_t w = src->header.w;
+    uint16_t h = src->header.h;
+    const uint8_t *data = src->data;
+
+    /* first pass: sizes only */
+    uint32_t runs = 0, colors = 0, alphas = 0;
+    for (uint32_t y = 0; y < h; y++) {
+        uint8_t type = 0xff;
+        uint16_t len = 0;
+        for (uint32_t x = 0; x < w; x++) {
+            uint8_t t = px_type(data[(y * w + x) * LV_IMG_PX_SIZE_ALPHA_BYTE + LV_IMG_PX_SIZE_ALPHA_BYTE - 1]);
+            if (t != type || len == RUN_MAX_LEN) {
+                runs++;
+                type = t;
+                len = 0;
+            }
+            len++;
+            colors += (t != RUN_SKIP);
+            alphas += (t == RUN_BLEND);
+        }
+    }
+    uint32_t runs_off = (h + 1) * sizeof(row_t);
+    uint32_t colors_off = (runs_off + runs * sizeof(uint16_t) + sizeof(lv_color_t) - 1) & ~(sizeof(lv_color_t) - 1);
+    uint32_t alphas_off = colors_off + colors * sizeof(lv_color_t);
+    uint32_t bytes = alphas_off + alphas;
+    uint8_t *block = (stats.bytes + bytes <= budget) ? heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) : NULL;
+    if (!block) {
+        stats.rejected++;
+        DLOG(&log_tag, "%s: %u B over the budget", name, bytes);
+        return false;
+    }
+
+    row_t *row = (row_t *)block;
+    uint16_t *run = (uint16_t *)(block + runs_off);
+    lv_color_t *color = (lv_color_t *)(block + colors_off);
+    lv_opa_t *alpha = block + alphas_off;
+    uint32_t ri = 0, ci = 0, ai = 0;
+    for (uint32_t y = 0; y < h; y++) {
+        row[y].run = ri;
+        row[y].color = ci;
+        row[y].alpha = ai;
+        uint8_t type = 0xff;
+        for (uint32_t x = 0; x < w; x++) {
+            const uint8_t *px = &data[(y * w + x) * LV_IMG_PX_SIZE_ALPHA_BYTE];
+            lv_opa_t opa = px[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+            uint8_t t = px_type(opa);
+            if (t != type || RUN_LEN(run[ri - 1]) == RUN_MAX_LEN) {
+                run[ri++] = t << 14;
+                type = t;
+            }
+            run[ri - 1]++;
+            if (t != RUN_SKIP) {
+                memcpy(&color[ci++], px, sizeof(lv_color_t));
+            }
+            if (t == RUN_BLEND) {
+                alpha[ai++] = opa;
+            }
+        }
+    }
+    row[h].run = ri;
+    row[h].color = ci;
+    row[h].alpha = ai;
+
+    a->src = src;
+    a->bytes = bytes;
+    a->rows = row;
+    a->runs = run;
+    a->colors = color;
+    a->alphas = alpha;
+    stats.assets++;
+    stats.bytes += bytes;
+    /* lv_img blends every pixel of an ARGB image, the runs only the edge */
+    DLOG(&log_tag, "%s %ux%u: blended px %u -> %u, %u B", name, w, h, w * h, alphas, bytes);
+    return true;
+}
+
+static void blit(lv_draw_ctx_t *draw_ctx, const asset_t *a, const lv_area_t *coords, lv_opa_t opa)
+{
+    lv_area_t clip;
+    if (!_lv_area_intersect(&clip, coords, draw_ctx->clip_area)) {
+        return;
+    }
+    /* queued fills of the port may still be writing the buffer */
+    if (draw_ctx->wait_for_finish) {
+        draw_ctx->wait_for_finish(draw_ctx);
+    }
+
+    lv_coord_t buf_w = lv_area_get_width(draw_ctx->buf_area);
+    lv_coord_t cx1 = clip.x1 - coords->x1;
+    lv_coord_t cx2 = clip.x2 - coords->x1;
+    for (lv_coord_t y = clip.y1; y <= clip.y2; y++) {
+        const row_t *row = &a->rows[y - coords->y1];
+        lv_color_t *dst = (lv_color_t *)draw_ctx->buf + (y - draw_ctx->buf_area->y1) * buf_w
+                          + (coords->x1 - draw_ctx->buf_area->x1);
+        const lv_color_t *c = a->colors + row->color;
+        const lv_opa_t *m = a->alphas + row->alpha;
+        lv_coord_t x = 0;
+        for (uint32_t r = row->run; r < row[1].run && x <= cx2; r++) {
+            uint8_t type = RUN_TYPE(a->runs[r]);
+            lv_coord_t len = RUN_LEN(a->runs[r]);
+            lv_coord_t s = LV_MAX(x, cx1);
+            lv_coord_t e = LV_MIN(x + len - 1, cx2);
+            if (type == RUN_COPY) {
+                if (s <= e && opa >= LV_OPA_MAX) {
+                    lv_memcpy(&dst[s], &c[s - x], (e - s + 1) * sizeof(lv_color_t));
+                } else {
+                    for (lv_coord_t i = s; i <= e; i++) {
+                        dst[i] = lv_color_mix(c[i - x], dst[i], opa);
+                    }
+                }
+                c += len;
+            } else if (type == RUN_BLEND) {
+                for (lv_coord_t i = s; i <= e; i++) {
+                    lv_opa_t o = (opa >= LV_OPA_MAX) ? m[i - x] : (lv_opa_t)((m[i - x] * opa) >> 8);
+                    dst[i] = lv_color_mix(c[i - x], dst[i], o);
+                }
+                c += len;
+                m += len;
+            }
+            x += len;
+        }
+    }
+}
+
+/**
+ * Only the display's draw buffer is known to hold plain lv_color_t pixels. Snapshots may write
+ * ARGB through set_px_cb, layers have buffers of their own.
+ */
+static bool draws_to_disp(const lv_draw_ctx_t *draw_ctx)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    return disp && !disp->driver->set_px_cb && draw_ctx->buf == disp->driver->draw_buf->buf_act;
+}
+
+/**
+ * @return false to leave the image to lv_img
+ */
+static bool runs_draw(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_img_t *img = (lv_img_t *)obj;
+    const void *src = lv_img_get_src(obj);
+    const asset_t *a = (src && lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE) ? find(ui_asset_pool_get_src(src)) : NULL;
+    if (!a || img->w == 0 || img->h == 0) {
+        return false;
+    }
+
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    lv_obj_init_draw_img_dsc(obj, LV_PART_MAIN, &dsc);
+    lv_area_t coords;
+    lv_obj_get_content_coords(obj, &coords);
+    if (!draws_to_disp(draw_ctx) || lv_img_get_zoom(obj) != LV_IMG_ZOOM_NONE || lv_img_get_angle(obj)
+            || dsc.recolor_opa > LV_OPA_MIN || dsc.blend_mode != LV_BLEND_MODE_NORMAL
+            || img->offset.x || img->offset.y || lv_area_get_width(&coords) != img->w
+            || lv_area_get_height(&coords) != img->h || lv_draw_mask_is_any(draw_ctx->clip_area)) {
+        stats.fallbacks++;
+        return false;
+    }
+    if (dsc.opa <= LV_OPA_MIN) {
+        return false;
+    }
+
+    /* background and border of the lv_obj base, then the runs instead of the lv_img pass */
+    if (lv_obj_event_base(&lv_img_class, e) != LV_RES_OK) {
+        return true;
+    }
+    blit(draw_ctx, a, &coords, dsc.opa);
+    stats.blits++;
+    return true;
+}
+
+static void runs_event(const lv_obj_class_t *class_p, lv_event_t *e)
+{
+    LV_UNUSED(class_p);
+
+    if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN && runs_draw(e)) {
+        return;
+    }
+    lv_obj_event_base(&ui_img_runs_class, e);
+}
+
+const lv_obj_class_t ui_img_runs_class = {
+    .base_class = &lv_img_class,
+    .event_cb = runs_event,
+    .width_def = LV_SIZE_CONTENT,
+    .height_def = LV_SIZE_CONTENT,
+    .instance_size = sizeof(lv_img_t),
+};
+
+lv_obj_t *ui_img_runs_create(lv_obj_t *parent)
+{
+    lv_obj_t *obj = lv_obj_class_create_obj(&ui_img_runs_class, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+void ui_img_runs_get_stats(ui_img_runs_stats_t *out)
+{
+    *out = stats;
+}
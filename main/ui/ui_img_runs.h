@@ -0,0 +1,45 @@
+#ifndef UI_IMG_RUNS_H__
+#define UI_IMG_RUNS_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint16_t assets;
+    uint16_t rejected;      /* didn't fit the budget or not LV_IMG_CF_TRUE_COLOR_ALPHA */
+    uint32_t bytes;
+    uint32_t blits;         /* draws done from the runs */
+    uint32_t fallbacks;     /* draws left to LVGL: zoomed, rotated, recoloured or masked */
+} ui_img_runs_stats_t;
+
+void ui_img_runs_init(uint32_t budget);
+
+/**
+ * Split `src` (LV_IMG_CF_TRUE_COLOR_ALPHA) into per-row runs of transparent, opaque and
+ * partially transparent pixels, stored in internal RAM with the colours of the visible pixels
+ * and the alpha of the edge pixels only. Done once per asset, `name` (a literal) is logged
+ * with the blended pixels before and after.
+ * @return false if it isn't encoded
+ */
+bool ui_img_runs_encode(const lv_img_dsc_t *src, const char *name);
+
+extern const lv_obj_class_t ui_img_runs_class;
+
+/**
+ * Create an lv_img that draws from the runs of its source (or of the asset pool copy's
+ * original) while it is shown 1:1 on the display: transparent runs are skipped, opaque runs
+ * copied and only the edge pixels blended. Anything else, snapshots included, is drawn by
+ * lv_img as before.
+ */
+lv_obj_t *ui_img_runs_create(lv_obj_t *parent);
+
+void ui_img_runs_get_stats(ui_img_runs_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,9 +1,16 @@
 #include "lvgl.h"
 #include <stdio.h>
+#include "dlog.h"
+#include "dev_state.h"
 #include "ui.h"
+#include "ui_asset_pool.h"
+#include "ui_coalesce.h"
+#include "ui_digits.h"
 #include "ui_light.h"
+#include "ui_state.h"
 
 static const char *TAG = "ui light";
+DLOG_TAG_DEFINE(log_tag, "light", 4);
 
 static lv_obj_t *arc;
 static lv_obj_t *img;
@@ -17,7 +24,12 @@ static void brightness_event_cb(lv_event_t *e)
     lv_obj_t *label = lv_event_get_user_data(e);
 
     if (code == LV_EVENT_VALUE_CHANGED) {
-        lv_label_set_text_fmt(label, "%d", lv_arc_get_value(obj));
+        ui_digits_set_value(label, lv_arc_get_value(obj));
+
+        ui_digits_stats_t stats;
+        ui_digits_get_stats(label, &stats);
+        DLOG(&log_tag, "value: %u updates, %u cells, %u px invalidated, last %u us, max %u us, %u elided",
+             stats.updates, stats.cells_changed, stats.inv_px, stats.last_us, stats.max_us, ui_coalesce_get_elided(obj));
         lv_obj_set_style_img_opa(img, lv_arc_get_value(obj) * 255 / 100, 0);
     }
 }
@@ -85,7 +97,7 @@ void ui_light_init(ret_cb_t ret_cb)
     lv_arc_set_rotation(arc, 180);
     lv_arc_set_bg_angles(arc, 0, 180);
     // lv_arc_set_angles(arc, 0, 30);
-    lv_arc_set_value(arc, 30);
+    lv_arc_set_value(arc, dev_state_get(DEV_STATE_BRIGHTNESS));
     // lv_arc_set_range(arc, 0, 100);
     lv_obj_set_style_arc_width(arc, 20, LV_PART_MAIN);
     lv_obj_set_style_arc_width(arc, 20, LV_PART_INDICATOR);
@@ -113,11 +125,8 @@ void ui_light_init(ret_cb_t ret_cb)
     lv_obj_set_style_text_align(label2, LV_TEXT_ALIGN_CENTER, 0);
     lv_obj_align(label2, LV_ALIGN_CENTER, 40, -10);
 
-    lv_obj_t *label3 = lv_label_create(tab1);
-    lv_label_set_text_fmt(label3, "%d", lv_arc_get_value(arc));
-    lv_obj_set_style_text_font(label3, &lv_font_montserrat_40, 0);
-    lv_obj_set_width(label3, 150);  /*Set smaller width to make the lines wrap*/
-    lv_obj_set_style_text_align(label3, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_t *label3 = ui_digits_create(tab1, &lv_font_montserrat_40, "0123456789", 3);
+    ui_digits_set_value(label3, lv_arc_get_value(arc));
     lv_obj_align(label3, LV_ALIGN_CENTER, 0, 0);
 
     LV_IMG_DECLARE(light_brightness);
@@ -127,7 +136,8 @@ void ui_light_init(ret_cb_t ret_cb)
     lv_obj_set_style_bg_color(img, lv_color_make(200, 0, 0), 0);
     lv_obj_set_style_img_opa(img, lv_arc_get_value(arc) * 255 / 100, 0);
 
-    lv_obj_add_event_cb(arc, brightness_event_cb, LV_EVENT_VALUE_CHANGED, label3);
+    ui_coalesce_value_changed(arc, brightness_event_cb, label3);
+    ui_state_bind_value(arc, DEV_STATE_BRIGHTNESS);
 
     lv_anim_t a1;
     lv_anim_init(&a1);
@@ -153,6 +163,7 @@ void ui_light_init(ret_cb_t ret_cb)
     cw = lv_colorwheel_create(tab2, true);
     lv_obj_set_size(cw, 180, 180);
     lv_obj_center(cw);
+    ui_state_bind_value(cw, DEV_STATE_HUE);
 
     /**
      * Tab 3 for colorwheel
@@ -170,11 +181,15 @@ void ui_light_init(ret_cb_t ret_cb)
     // lv_obj_add_event_cb(tabview, light_event_cb, LV_EVENT_CLICKED, NULL);
     lv_obj_add_event_cb(arc, light_event_cb, LV_EVENT_LONG_PRESSED, NULL);
     lv_obj_add_event_cb(cw, light_event_cb, LV_EVENT_LONG_PRESSED, NULL);
+
+    static const lv_img_dsc_t *const hot_assets[] = {&light_brightness};
+    ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
 }
 
 void ui_light_set_brightness(uint8_t value)
 {
-    lv_arc_set_value(arc, value);
+    /* the page shows it once it's open, no need for the LVGL lock */
+    dev_state_set(DEV_STATE_BRIGHTNESS, value);
 }
 
 void ui_light_delete(void)
@@ -1,10 +1,17 @@
 #include "lvgl.h"
 #include <stdio.h>
 #include "esp_system.h"
+#include "esp_timer.h"
 #ifdef ESP_IDF_VERSION
 #include "esp_log.h"
 #endif
+#include "lvgl_port.h"
+#include "dlog.h"
 #include "ui.h"
+#include "ui_asset_pool.h"
+#include "ui_census.h"
+#include "ui_profiler.h"
+#include "ui_theme.h"
 #include "ui_clock.h"
 #include "ui_light.h"
 #include "ui_player.h"
@@ -16,6 +23,8 @@ typedef struct {
     const char *name;
     const lv_img_dsc_t *icon;
     void (*create)(ret_cb_t ret_cb);
+    bool (*preload)(void);      /* optional, builds the page hidden a bit per call, true when done */
+    void (*discard)(void);      /* drops what preload built */
 } ui_menu_app_t;
 
 LV_IMG_DECLARE(icon_clock);
@@ -25,27 +34,54 @@ LV_IMG_DECLARE(icon_player);
 LV_IMG_DECLARE(icon_weather);
 LV_IMG_DECLARE(icon_washing);
 
+DLOG_TAG_DEFINE(log_tag, "menu", 20);
+
 static ui_menu_app_t menu[] = {
     {"clock", &icon_clock, ui_clock_init},
     {"washing", &icon_washing, ui_washing_init},
-    {"fans", &icon_fans, ui_fan_init},
+    {"fans", &icon_fans, ui_fan_init, ui_fan_preload, ui_fan_discard},
     {"light", &icon_light, ui_light_init},
     {"player", &icon_player, ui_player_init},
-    {"weather", &icon_weather, ui_weather_init},
+    {"weather", &icon_weather, ui_weather_init, ui_weather_preload, ui_weather_discard},
+};
+
+/* kept in internal RAM while the menu is on screen, the centred icons first */
+static const lv_img_dsc_t *const hot_assets[] = {
+    &icon_clock,
+    &icon_washing,
+    &icon_weather,
+    &icon_fans,
+    &icon_light,
+    &icon_player,
 };
 
 #define APP_NUM 5//(sizeof(menu) / sizeof(ui_menu_app_t))
 #define APP_ICON_GAP_PIXEL (80)
 #define ICONS_SHOW_NUM 3
+#define MENU_ANIM_TIME (200)
+#define MENU_ANIM_MIN_TIME (60)     /* per step while more steps are queued */
+#define MENU_SKIP_STEPS (2)         /* queued steps beyond this are jumped over, only the last is animated */
+#define MENU_PENDING_MAX (100)
+#define MENU_PRELOAD 1              /* 0 builds the app page only on click, e.g. to compare the latency */
+#define PRELOAD_PERIOD_MS (8)
+#define PRELOAD_SLICE_US (2000)     /* per timer run, leaves the rest of the frame to the carousel */
 
 static uint8_t app_index = 0;
 static lv_obj_t *page;
 static lv_obj_t *image_bg;
 static bool anim_flag = false;
+static int8_t anim_dir;
+static int8_t pending_steps;
 static lv_obj_t *icons[ICONS_SHOW_NUM + 1];
 static lv_coord_t old_y[ICONS_SHOW_NUM + 1];
 static uint8_t visible_index[ICONS_SHOW_NUM];
 static uint8_t invisable_index;
+static lv_timer_t *preload_timer;
+static int8_t preload_app = -1;
+static bool preload_done;
+static int64_t click_us;
+static uint32_t click_frames;
+static bool click_preloaded;
 
 static void menu_anim_ready_cb(lv_anim_t *a);
 
@@ -72,8 +108,65 @@ static uint32_t get_app_index(int8_t offset)
     return get_num_offset(app_index, APP_NUM, offset);
 }
 
+static void preload_timer_cb(lv_timer_t *t)
+{
+    int64_t start = esp_timer_get_time();
+    do {
+        preload_done = menu[preload_app].preload();
+    } while (!preload_done && esp_timer_get_time() - start < PRELOAD_SLICE_US);
+
+    if (preload_done) {
+        lv_timer_del(t);
+        preload_timer = NULL;
+    }
+}
+
+static void preload_cancel(void)
+{
+    if (preload_timer) {
+        lv_timer_del(preload_timer);
+        preload_timer = NULL;
+    }
+    if (preload_app >= 0) {
+        menu[preload_app].discard();
+        preload_app = -1;
+    }
+}
+
+/**
+ * Start building the page of the app that ends up centred, while the carousel still moves.
+ */
+static void preload_start(uint32_t index)
+{
+#if MENU_PRELOAD
+    if (preload_app == (int8_t)index) {
+        return;
+    }
+    preload_cancel();
+    if (menu[index].preload) {
+        preload_app = index;
+        preload_done = false;
+        preload_timer = lv_timer_create(preload_timer_cb, PRELOAD_PERIOD_MS, NULL);
+    }
+#endif
+}
+
+/**
+ * Polls the frame counter after a click, the first frame completed is the one showing the app.
+ */
+static void latency_timer_cb(lv_timer_t *t)
+{
+    if (lvgl_port_get_frame_count() == click_frames) {
+        return;
+    }
+    lv_timer_del(t);
+    DLOG(&log_tag, "%s: click to first frame %u us, preloaded=%d", menu[get_app_index(0)].name,
+         (uint32_t)(esp_timer_get_time() - click_us), click_preloaded);
+}
+
 static void app_return_cb(void *args)
 {
+    ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
     ui_add_obj_to_encoder_group(image_bg);
 }
 
@@ -94,47 +187,188 @@ static void menu_anim_exec_cb(void *args, int32_t v)
     }
 }
 
+/**
+ * Shorter steps while more are queued, the last one gets the full ease in and out.
+ */
+static uint32_t menu_step_time(void)
+{
+    return LV_MAX(MENU_ANIM_MIN_TIME, MENU_ANIM_TIME / (1 + LV_ABS(pending_steps)));
+}
+
+static void menu_step_start(int8_t dir)
+{
+    int8_t extra_icon_index = dir * ((ICONS_SHOW_NUM / 2) + 1);
+
+    lv_img_set_src(icons[invisable_index], ui_asset_pool_get(menu[get_app_index(extra_icon_index)].icon));
+    lv_obj_align(icons[invisable_index], LV_ALIGN_CENTER, 0, (extra_icon_index)* APP_ICON_GAP_PIXEL);
+    lv_img_set_zoom(icons[invisable_index], 1);
+
+    for (size_t i = 0; i < ICONS_SHOW_NUM + 1; i++) {
+        old_y[i] = lv_obj_get_y_aligned(icons[i]);
+    }
+
+    anim_flag = true;
+    anim_dir = dir;
+    lv_anim_t a1;
+    lv_anim_init(&a1);
+    lv_anim_set_var(&a1, (void *)extra_icon_index);
+    lv_anim_set_values(&a1, 0, APP_ICON_GAP_PIXEL);
+    lv_anim_set_exec_cb(&a1, menu_anim_exec_cb);
+    /* steps followed by more run through at constant speed instead of easing to a stop */
+    lv_anim_set_path_cb(&a1, pending_steps ? lv_anim_path_linear : lv_anim_path_ease_in_out);
+    lv_anim_set_ready_cb(&a1, menu_anim_ready_cb);
+    lv_anim_set_time(&a1, menu_step_time());
+    lv_anim_set_user_data(&a1, (void *)extra_icon_index);
+    lv_anim_start(&a1);
+    lvgl_port_lowres_hold();
+}
+
+static lv_anim_t *menu_step_anim(void)
+{
+    int8_t extra_icon_index = anim_dir * ((ICONS_SHOW_NUM / 2) + 1);
+    return lv_anim_get((void *)extra_icon_index, menu_anim_exec_cb);
+}
+
+/**
+ * The direction the icons move in: the step's, or the opposite once it was turned around.
+ */
+static int8_t menu_step_motion(const lv_anim_t *a)
+{
+    return (a && a->end_value == 0) ? -anim_dir : anim_dir;
+}
+
+/**
+ * Shorten the running step to what the queue asks for, scaling the elapsed time along so
+ * the icons continue from where they are.
+ */
+static void menu_step_retime(void)
+{
+    lv_anim_t *a = menu_step_anim();
+    uint32_t time = menu_step_time();
+    if (!a || a->act_time <= 0 || (uint32_t)a->time <= time) {
+        return;
+    }
+    a->act_time = a->act_time * time / a->time;
+    a->time = time;
+}
+
+/**
+ * Send the running step back from where the icons are, a reversed step ends where it began.
+ */
+static void menu_step_reverse(lv_anim_t *a)
+{
+    int32_t v = (a->act_time > 0) ? a->path_cb(a) : a->start_value;
+    int32_t end = a->end_value ? 0 : APP_ICON_GAP_PIXEL;
+    lv_anim_t b = *a;
+
+    lv_anim_set_values(&b, v, end);
+    lv_anim_set_path_cb(&b, lv_anim_path_ease_out);
+    lv_anim_set_time(&b, LV_MAX(1, menu_step_time() * LV_ABS(end - v) / APP_ICON_GAP_PIXEL));
+    lv_anim_set_delay(&b, 0);
+    /* replaces `a`, same var and exec_cb */
+    lv_anim_start(&b);
+}
+
+/**
+ * Drop the queued steps and put the running one at its end, so nothing moves the carousel
+ * or holds the low resolution once an app opens.
+ */
+static void menu_step_finish(void)
+{
+    pending_steps = 0;
+    lv_anim_t *a = menu_step_anim();
+    if (!a) {
+        return;
+    }
+    lv_anim_t done = *a;
+    lv_anim_del(done.var, menu_anim_exec_cb);
+    menu_anim_exec_cb(done.var, done.end_value);
+    menu_anim_ready_cb(&done);
+}
+
+/**
+ * Put the visible icons of app_index in place without animation, used when queued steps are
+ * skipped.
+ */
+static void menu_layout_icons(void)
+{
+    for (int i = 0; i < ICONS_SHOW_NUM; i++) {
+        lv_obj_t *icon = icons[visible_index[i]];
+        lv_img_set_src(icon, ui_asset_pool_get(menu[get_app_index(i - (ICONS_SHOW_NUM / 2))].icon));
+        lv_obj_align(icon, LV_ALIGN_CENTER, 0, (i - (ICONS_SHOW_NUM / 2)) * APP_ICON_GAP_PIXEL);
+        int32_t abs_y = LV_ABS(lv_obj_get_y_aligned(icon));
+        lv_img_set_zoom(icon, (abs_y < 130) ? 256 * (130 - abs_y) / 100 : 1);
+    }
+}
+
 static void menu_event_cb(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t *obj = lv_event_get_target(e);
 
-    printf("evt=%d\n", code);
+    DLOG(&log_tag, "evt=%d", code);
     if (LV_EVENT_FOCUSED == code) {
         lv_group_set_editing(lv_group_get_default(), true);
-    } else if (LV_EVENT_KEY == code && false == anim_flag) {
-
+    } else if (LV_EVENT_KEY == code) {
         uint32_t key = lv_event_get_key(e);
-        int8_t  extra_icon_index = 0;
+        int8_t dir = 0;
         if (LV_KEY_RIGHT == key) {
-            extra_icon_index = (ICONS_SHOW_NUM / 2) + 1;
+            dir = 1;
         } else if (LV_KEY_LEFT == key) {
-            extra_icon_index = -(ICONS_SHOW_NUM / 2) - 1;
+            dir = -1;
+        }
+        if (!dir) {
+            return;
         }
 
-        lv_img_set_src(icons[invisable_index], menu[get_app_index(extra_icon_index)].icon);
-        lv_obj_align(icons[invisable_index], LV_ALIGN_CENTER, 0, (extra_icon_index)* APP_ICON_GAP_PIXEL);
-        lv_img_set_zoom(icons[invisable_index], 1);
+        if (anim_flag) {
+            lv_anim_t *a = menu_step_anim();
+            int8_t motion = menu_step_motion(a);
+            if (a && !pending_steps && dir != motion) {
+                /* the hand turned back before the step landed: turn the step around */
+                menu_step_reverse(a);
+                motion = dir;
+            } else {
+                /* keep up with the hand: queue the detent and hurry the step on screen */
+                pending_steps = LV_CLAMP(-MENU_PENDING_MAX, pending_steps + dir, MENU_PENDING_MAX);
+                if (dir == motion) {
+                    menu_step_retime();
+                }
+            }
+            /* queued steps always go the way the icons move */
+            preload_start(get_app_index((motion == anim_dir ? anim_dir : 0) + pending_steps));
+        } else {
+            menu_step_start(dir);
+            preload_start(get_app_index(dir));
+        }
+    } else if (LV_EVENT_CLICKED == code) {
+        click_us = esp_timer_get_time();
+        click_frames = lvgl_port_get_frame_count();
+        menu_step_finish();
+        click_preloaded = (preload_app == (int8_t)get_app_index(0)) && preload_done;
+        lv_timer_create(latency_timer_cb, 1, NULL);
 
-        for (size_t i = 0; i < ICONS_SHOW_NUM + 1; i++) {
-            old_y[i] = lv_obj_get_y_aligned(icons[i]);
+        /* a page still being built is finished by create(), a page of another app is dropped */
+        if (preload_app != (int8_t)get_app_index(0)) {
+            preload_cancel();
+        } else if (preload_timer) {
+            lv_timer_del(preload_timer);
+            preload_timer = NULL;
         }
+        preload_app = -1;
 
-        anim_flag = true;
-        lv_anim_t a1;
-        lv_anim_init(&a1);
-        lv_anim_set_var(&a1, (void *)extra_icon_index);
-        lv_anim_set_values(&a1, 0, APP_ICON_GAP_PIXEL);
-        lv_anim_set_exec_cb(&a1, menu_anim_exec_cb);
-        lv_anim_set_path_cb(&a1, lv_anim_path_ease_in_out);
-        lv_anim_set_ready_cb(&a1, menu_anim_ready_cb);
-        lv_anim_set_time(&a1, 200);
-        lv_anim_set_user_data(&a1, (void *)extra_icon_index);
-        lv_anim_start(&a1);
-    } else if (LV_EVENT_CLICKED == code) {
         lv_group_set_editing(lv_group_get_default(), false);
         ui_remove_all_objs_from_encoder_group();
         menu[get_app_index(0)].create(app_return_cb);
+        ui_profiler_attach(lv_scr_act());
+
+        ui_census_t census;
+        /* the app's page only, the menu stays behind it */
+        ui_census_take(ui_get_top_page(), &census);
+        DLOG(&log_tag, "%s styles: objs=%u, refs=%u, local props=%u, %u bytes", menu[get_app_index(0)].name,
+             census.styles.objs, census.styles.style_refs, census.styles.local_props, census.styles.bytes);
+        DLOG(&log_tag, "%s census: %u B objs, %u event cbs %u B, %u anims", menu[get_app_index(0)].name,
+             census.obj_bytes, census.event_dscs, census.event_bytes, census.anims);
     }
 }
 
@@ -142,13 +376,30 @@ static void menu_anim_ready_cb(lv_anim_t *a)
 {
     int8_t extra_icon_index = (int8_t)lv_anim_get_user_data(a);
     int8_t dir = extra_icon_index > 0 ? 1 : -1;
-    app_index = get_app_index(dir);
-    invisable_index = get_num_offset(invisable_index, ICONS_SHOW_NUM + 1, dir);
-    for (size_t i = 0; i < ICONS_SHOW_NUM; i++) {
-        visible_index[i] = get_num_offset(visible_index[i], ICONS_SHOW_NUM + 1, dir);
+    /* a reversed step put the icons back where they were */
+    if (a->end_value) {
+        app_index = get_app_index(dir);
+        invisable_index = get_num_offset(invisable_index, ICONS_SHOW_NUM + 1, dir);
+        for (size_t i = 0; i < ICONS_SHOW_NUM; i++) {
+            visible_index[i] = get_num_offset(visible_index[i], ICONS_SHOW_NUM + 1, dir);
+        }
     }
     anim_flag = false;
-    printf("dir=%d, app_index=%d, invisable_index=%d\n", dir, app_index, invisable_index);
+    lvgl_port_lowres_release();
+    DLOG(&log_tag, "dir=%d, app_index=%d, invisable_index=%d, pending=%d", dir, app_index, invisable_index,
+         pending_steps);
+
+    if (pending_steps) {
+        dir = pending_steps > 0 ? 1 : -1;
+        if (LV_ABS(pending_steps) > MENU_SKIP_STEPS) {
+            /* too far behind: the icons in between are never shown, so they aren't rendered either */
+            app_index = get_app_index(pending_steps - dir);
+            pending_steps = dir;
+            menu_layout_icons();
+        }
+        pending_steps -= dir;
+        menu_step_start(dir);
+    }
 }
 
 void ui_menu_init(void)
@@ -194,6 +445,8 @@ void ui_menu_init(void)
     lv_obj_add_event_cb(image_bg, menu_event_cb, LV_EVENT_KEY, NULL);
     lv_obj_add_event_cb(image_bg, menu_event_cb, LV_EVENT_CLICKED, NULL);
     ui_add_obj_to_encoder_group(image_bg);
+    ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
+    ui_profiler_attach(lv_scr_act());
 }
 
 
@@ -1,7 +1,10 @@
 #include "lvgl.h"
 #include <stdio.h>
+#include "dev_state.h"
 #include "ui.h"
+#include "ui_digits.h"
 #include "ui_player.h"
+#include "ui_state.h"
 
 static lv_obj_t *page;
 static ret_cb_t return_callback;
@@ -72,7 +75,7 @@ void ui_player_init(ret_cb_t ret_cb)
     lv_arc_set_rotation(arc_volume, 55);
     lv_arc_set_bg_angles(arc_volume, 0, 90);
     lv_arc_set_range(arc_volume, 0, 30);
-    lv_arc_set_value(arc_volume, 18);
+    lv_arc_set_value(arc_volume, dev_state_get(DEV_STATE_VOLUME));
     lv_obj_set_style_arc_width(arc_volume, 6, LV_PART_MAIN);
     lv_obj_set_style_arc_width(arc_volume, 6, LV_PART_INDICATOR);
     lv_obj_set_style_outline_width(arc_volume, 2, LV_STATE_FOCUSED | LV_PART_KNOB);
@@ -86,6 +89,7 @@ void ui_player_init(ret_cb_t ret_cb)
     lv_obj_set_style_arc_opa(arc_volume, LV_OPA_60, LV_PART_INDICATOR);
     lv_obj_set_style_arc_opa(arc_volume, LV_OPA_60, LV_PART_KNOB);
     lv_obj_center(arc_volume);
+    ui_state_bind_value(arc_volume, DEV_STATE_VOLUME);
 
     lv_obj_t *label_speaker = lv_label_create(img);
     lv_label_set_text(label_speaker, LV_SYMBOL_VOLUME_MAX);
@@ -112,11 +116,10 @@ void ui_player_init(ret_cb_t ret_cb)
     lv_obj_set_style_text_align(label_album, LV_TEXT_ALIGN_CENTER, 0);
     lv_obj_align_to(label_album, label_name, LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
 
-    lv_obj_t *label_time = lv_label_create(img);
-    lv_label_set_text_fmt(label_time, "%02d:%02d | %02d:%02d", 1, 24, 2, 15);
-    lv_obj_set_style_text_font(label_time, &lv_font_montserrat_12, 0);
-    lv_obj_set_width(label_time, 150);
-    lv_obj_set_style_text_align(label_time, LV_TEXT_ALIGN_CENTER, 0);
+    char time_str[16];
+    lv_snprintf(time_str, sizeof(time_str), "%02d:%02d | %02d:%02d", 1, 24, 2, 15);
+    lv_obj_t *label_time = ui_digits_create(img, &lv_font_montserrat_12, "0123456789:|", 13);
+    ui_digits_set_text(label_time, time_str);
     lv_obj_align(label_time, LV_ALIGN_CENTER, 0, 40);
 
     lv_obj_t *btn_mode = lv_btn_create(img);
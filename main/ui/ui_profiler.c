@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "lvgl_port.h"
+#include "ui_census.h"
+#include "ui_profiler.h"
+
+#define SLOT_MAX            (96)
+#define REPORT_OBJS         (5)
+#define REPORT_CLASSES      (4)
+#define REPORT_INTERVAL_MS  (1000)  /* printing the report costs frames of its own */
+#define PATH_DEPTH          (8)
+
+typedef struct {
+    lv_obj_t *obj;
+    int64_t begin_us;
+    uint32_t frame_us;
+} slot_t;
+
+static slot_t slots[SLOT_MAX];
+static uint32_t budget;
+static uint32_t last_report;
+static ui_profiler_stats_t stats;
+
+static void obj_path(lv_obj_t *obj, char *buf, size_t size)
+{
+    lv_obj_t *chain[PATH_DEPTH];
+    int depth = 0;
+    for (; obj && lv_obj_get_parent(obj) && depth < PATH_DEPTH; obj = lv_obj_get_parent(obj)) {
+        chain[depth++] = obj;
+    }
+    int len = snprintf(buf, size, "%s", lv_obj_get_parent(obj) ? "..." : "scr");
+    while (depth-- && len < (int)size) {
+        ui_class_t cls = ui_census_get_class(lv_obj_get_class(chain[depth]));
+        len += snprintf(buf + len, size - len, "/%s.%u", ui_census_class_name(cls), (unsigned)lv_obj_get_index(chain[depth]));
+    }
+}
+
+/**
+ * The class handlers run before the event callbacks, so BEGIN to END brackets the class drawing
+ * and the callbacks of the other events. Children are drawn between DRAW_MAIN_END and
+ * DRAW_POST_BEGIN and don't count for the parent.
+ */
+static void prof_event_cb(lv_event_t *e)
+{
+    slot_t *s = lv_event_get_user_data(e);
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_DRAW_MAIN_BEGIN:
+    case LV_EVENT_DRAW_POST_BEGIN:
+        s->begin_us = esp_timer_get_time();
+        break;
+    case LV_EVENT_DRAW_MAIN_END:
+    case LV_EVENT_DRAW_POST_END:
+        if (s->begin_us) {
+            s->frame_us += esp_timer_get_time() - s->begin_us;
+            s->begin_us = 0;
+        }
+        break;
+    case LV_EVENT_DELETE:
+        s->obj = NULL;
+        stats.objs--;
+        break;
+    default:
+        break;
+    }
+}
+
+static void report(uint32_t render_us)
+{
+    slot_t *top[REPORT_OBJS] = {0};
+    uint32_t class_us[UI_CLASS_NUM] = {0};
+    uint32_t drawn_us = 0;
+
+    for (size_t i = 0; i < SLOT_MAX; i++) {
+        slot_t *s = &slots[i];
+        if (!s->obj || !s->frame_us) {
+            continue;
+        }
+        drawn_us += s->frame_us;
+        class_us[ui_census_get_class(lv_obj_get_class(s->obj))] += s->frame_us;
+        for (size_t j = 0; j < REPORT_OBJS; j++) {
+            if (!top[j] || s->frame_us > top[j]->frame_us) {
+                memmove(&top[j + 1], &top[j], (REPORT_OBJS - j - 1) * sizeof(top[0]));
+                top[j] = s;
+                break;
+            }
+        }
+    }
+
+    printf("frame %u us over the %u us budget, objects drew %u us\n", render_us, budget, drawn_us);
+    char path[96];
+    for (size_t i = 0; i < REPORT_OBJS && top[i]; i++) {
+        obj_path(top[i]->obj, path, sizeof(path));
+        printf("  %6u us  %s\n", top[i]->frame_us, path);
+    }
+    for (size_t n = 0; n < REPORT_CLASSES; n++) {
+        size_t max = 0;
+        for (size_t i = 1; i < UI_CLASS_NUM; i++) {
+            if (class_us[i] > class_us[max]) {
+                max = i;
+            }
+        }
+        if (!class_us[max]) {
+            break;
+        }
+        printf("  %6u us  all %s\n", class_us[max], ui_census_class_name(max));
+        class_us[max] = 0;
+    }
+}
+
+static void frame_cb(uint32_t render_us, uint32_t px)
+{
+    stats.frames++;
+    if (render_us > budget) {
+        stats.overruns++;
+        if (lv_tick_elaps(last_report) >= REPORT_INTERVAL_MS || stats.reported == 0) {
+            stats.reported++;
+            report(render_us);
+            last_report = lv_tick_get();
+        }
+    }
+    for (size_t i = 0; i < SLOT_MAX; i++) {
+        slots[i].frame_us = 0;
+    }
+}
+
+static lv_obj_tree_walk_res_t attach_cb(lv_obj_t *obj, void *user_data)
+{
+    if (lv_obj_get_event_user_data(obj, prof_event_cb)) {
+        return LV_OBJ_TREE_WALK_NEXT;
+    }
+    for (size_t i = 0; i < SLOT_MAX; i++) {
+        slot_t *s = &slots[i];
+        if (!s->obj) {
+            lv_memset_00(s, sizeof(slot_t));
+            s->obj = obj;
+            lv_obj_add_event_cb(obj, prof_event_cb, LV_EVENT_ALL, s);
+            stats.objs++;
+            return LV_OBJ_TREE_WALK_NEXT;
+        }
+    }
+    stats.untracked++;
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+void ui_profiler_init(uint32_t budget_us)
+{
+    budget = budget_us;
+    lvgl_port_set_frame_cb(frame_cb);
+}
+
+void ui_profiler_attach(lv_obj_t *root)
+{
+    if (!budget) {
+        return;
+    }
+    lv_obj_tree_walk(root, attach_cb, NULL);
+}
+
+void ui_profiler_get_stats(ui_profiler_stats_t *out)
+{
+    *out = stats;
+}
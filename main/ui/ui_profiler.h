@@ -0,0 +1,38 @@
+#ifndef UI_PROFILER_H__
+#define UI_PROFILER_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t frames;
+    uint32_t overruns;      /* frames longer than the budget */
+    uint32_t reported;      /* overruns that were logged, the others fell in the report interval */
+    uint32_t objs;          /* objects with a profiling slot */
+    uint32_t untracked;     /* objects that found the slot table full */
+} ui_profiler_stats_t;
+
+/**
+ * Start measuring frames. A frame that takes longer than `budget_us` from render start to the
+ * end of the refresh gets logged with the objects and classes that took the most draw time,
+ * e.g. `scr/obj.1/colorwheel.0`. Call from the LVGL task.
+ */
+void ui_profiler_init(uint32_t budget_us);
+
+/**
+ * Time the drawing of `root` and all its children, objects that are already timed are skipped,
+ * so call it again after a page was created. Does nothing before ui_profiler_init(). The clock
+ * is read four times per object and redrawn area, which is measured as well.
+ */
+void ui_profiler_attach(lv_obj_t *root);
+
+void ui_profiler_get_stats(ui_profiler_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
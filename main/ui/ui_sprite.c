@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "lvgl.h"
+#include "dlog.h"
+#include "ui_sprite.h"
+
+/**
+ * Sheet layout: key frame | delta records. frame[i].offset points at the records that turn
+ * frame i - 1 into frame i, frame[0] wraps the last frame back to the first. A record is a
+ * rect_t followed by its w * h pixels, row by row.
+ */
+#define TILE        (8)
+#define PX_BYTES    (LV_IMG_PX_SIZE_ALPHA_BYTE)
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} rect_t;
+
+typedef struct {
+    uint32_t offset;
+    uint16_t rects;
+    lv_area_t bbox;     /* relative to the image, empty if nothing changed */
+} sprite_frame_t;
+
+struct _ui_sprite_sheet_t {
+    uint16_t w;
+    uint16_t h;
+    uint16_t frame_ms;
+    uint32_t frame_bytes;
+    sprite_frame_t *frames;
+    uint8_t *data;
+    ui_sprite_stats_t stats;
+};
+
+typedef struct {
+    ui_sprite_sheet_t *sheet;
+    lv_obj_t *img;
+    lv_timer_t *timer;
+    lv_img_dsc_t dsc;
+    uint8_t *frame;
+    uint16_t cur;
+} player_t;
+
+static const char *TAG = "sprite";
+DLOG_TAG_DEFINE(log_tag, "sprite", 4);
+
+static bool tile_changed(const ui_sprite_sheet_t *s, const uint8_t *cur, const uint8_t *prev, uint16_t x,
+                         uint16_t y, uint16_t w, uint16_t h)
+{
+    for (uint16_t row = y; row < y + h; row++) {
+        uint32_t off = ((uint32_t)row * s->w + x) * PX_BYTES;
+        if (memcmp(cur + off, prev + off, w * PX_BYTES)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Write the records that turn `prev` into `cur` to `out`, or only count their bytes if `out`
+ * is NULL. Changed tiles next to each other in a tile row become one rectangle.
+ */
+static uint32_t delta_encode(ui_sprite_sheet_t *s, const uint8_t *cur, const uint8_t *prev, uint8_t *out,
+                             sprite_frame_t *f)
+{
+    uint32_t size = 0;
+    f->rects = 0;
+    lv_area_set(&f->bbox, 0, 0, -1, -1);
+    for (uint16_t y = 0; y < s->h; y += TILE) {
+        uint16_t th = LV_MIN(TILE, s->h - y);
+        uint16_t x = 0;
+        while (x < s->w) {
+            if (!tile_changed(s, cur, prev, x, y, LV_MIN(TILE, s->w - x), th)) {
+                x += TILE;
+                continue;
+            }
+            uint16_t x1 = x;
+            while (x < s->w && tile_changed(s, cur, prev, x, y, LV_MIN(TILE, s->w - x), th)) {
+                x += TILE;
+            }
+            rect_t r = {x1, y, LV_MIN(x, s->w) - x1, th};
+            if (out) {
+                memcpy(out + size, &r, sizeof(r));
+                for (uint16_t row = 0; row < r.h; row++) {
+                    memcpy(out + size + sizeof(r) + row * r.w * PX_BYTES,
+                           cur + ((uint32_t)(r.y + row) * s->w + r.x) * PX_BYTES, r.w * PX_BYTES);
+                }
+            }
+            size += sizeof(r) + r.w * r.h * PX_BYTES;
+            f->rects++;
+            lv_area_t area = {r.x, r.y, r.x + r.w - 1, r.y + r.h - 1};
+            if (f->bbox.x2 < f->bbox.x1) {
+                f->bbox = area;
+            } else {
+                _lv_area_join(&f->bbox, &f->bbox, &area);
+            }
+        }
+    }
+    return size;
+}
+
+static void render(const ui_sprite_config_t *config, uint16_t index, uint8_t *px, uint32_t bytes)
+{
+    lv_memset_00(px, bytes);
+    config->render_cb(index, px, config->user_data);
+}
+
+ui_sprite_sheet_t *ui_sprite_sheet_create(const ui_sprite_config_t *config)
+{
+    LV_ASSERT_NULL(config->render_cb);
+    if (!config->frames) {
+        return NULL;
+    }
+
+    uint32_t frame_bytes = (uint32_t)config->w * config->h * PX_BYTES;
+    ui_sprite_sheet_t *s = lv_mem_alloc(sizeof(ui_sprite_sheet_t));
+    LV_ASSERT_MALLOC(s);
+    lv_memset_00(s, sizeof(ui_sprite_sheet_t));
+    s->w = config->w;
+    s->h = config->h;
+    s->frame_ms = LV_MAX(config->frame_ms, UI_SPRITE_MIN_FRAME_MS);
+    s->frame_bytes = frame_bytes;
+    s->frames = lv_mem_alloc(config->frames * sizeof(sprite_frame_t));
+    uint8_t *cur = heap_caps_malloc(frame_bytes, MALLOC_CAP_8BIT);
+    uint8_t *prev = heap_caps_malloc(frame_bytes, MALLOC_CAP_8BIT);
+    if (!s->frames || !cur || !prev) {
+        goto fail;
+    }
+
+    /* sizes first, the records are written by a second pass over the same frames */
+    uint32_t size = frame_bytes;
+    for (int pass = 0; pass < 2; pass++) {
+        render(config, 0, prev, frame_bytes);
+        if (pass) {
+            memcpy(s->data, prev, frame_bytes);
+        }
+        size = frame_bytes;
+        for (uint16_t i = 1; i <= config->frames; i++) {
+            sprite_frame_t *f = &s->frames[i % config->frames];
+            render(config, i % config->frames, cur, frame_bytes);
+            f->offset = size;
+            size += delta_encode(s, cur, prev, pass ? s->data + size : NULL, f);
+            s->stats.max_rects = LV_MAX(s->stats.max_rects, f->rects);
+            uint8_t *tmp = prev;
+            prev = cur;
+            cur = tmp;
+        }
+        if (!pass) {
+            s->data = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!s->data) {
+                ESP_LOGW(TAG, "no memory for a %u byte sheet", size);
+                goto fail;
+            }
+        }
+    }
+    free(cur);
+    free(prev);
+
+    s->stats.frames = config->frames;
+    s->stats.sheet_bytes = size;
+    s->stats.raw_bytes = config->frames * frame_bytes;
+    /* built on every visit to the page, inside the click to first frame window */
+    DLOG(&log_tag, "%u frames of %ux%u in %u bytes (%u whole), up to %u rects per frame",
+         config->frames, s->w, s->h, size, s->stats.raw_bytes, s->stats.max_rects);
+    return s;
+
+fail:
+    free(cur);
+    free(prev);
+    lv_mem_free(s->frames);
+    lv_mem_free(s);
+    return NULL;
+}
+
+static void delta_apply(const ui_sprite_sheet_t *s, uint8_t *frame, const sprite_frame_t *f)
+{
+    const uint8_t *rec = s->data + f->offset;
+    for (uint16_t i = 0; i < f->rects; i++) {
+        rect_t r;
+        memcpy(&r, rec, sizeof(r));
+        rec += sizeof(r);
+        for (uint16_t row = 0; row < r.h; row++) {
+            memcpy(frame + ((uint32_t)(r.y + row) * s->w + r.x) * PX_BYTES, rec, r.w * PX_BYTES);
+            rec += r.w * PX_BYTES;
+        }
+    }
+}
+
+static void player_timer_cb(lv_timer_t *t)
+{
+    player_t *p = t->user_data;
+    ui_sprite_sheet_t *s = p->sheet;
+
+    /* the frame stays where it is, playback continues from there once it's shown again */
+    if (!lv_obj_is_visible(p->img)) {
+        s->stats.skipped++;
+        return;
+    }
+    p->cur = (p->cur + 1) % s->stats.frames;
+    const sprite_frame_t *f = &s->frames[p->cur];
+    delta_apply(s, p->frame, f);
+    s->stats.played++;
+    if (f->bbox.x2 >= f->bbox.x1) {
+        lv_area_t area = f->bbox;
+        lv_area_move(&area, p->img->coords.x1, p->img->coords.y1);
+        lv_obj_invalidate_area(p->img, &area);
+        s->stats.inv_px += lv_area_get_size(&area);
+    }
+}
+
+static void player_delete_cb(lv_event_t *e)
+{
+    player_t *p = lv_event_get_user_data(e);
+    lv_timer_del(p->timer);
+    free(p->frame);
+    lv_mem_free(p);
+}
+
+bool ui_sprite_play(lv_obj_t *img, ui_sprite_sheet_t *sheet)
+{
+    player_t *p = lv_mem_alloc(sizeof(player_t));
+    LV_ASSERT_MALLOC(p);
+    lv_memset_00(p, sizeof(player_t));
+    p->frame = heap_caps_malloc(sheet->frame_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!p->frame) {
+        ESP_LOGW(TAG, "no memory for a %u byte frame", sheet->frame_bytes);
+        lv_mem_free(p);
+        return false;
+    }
+    memcpy(p->frame, sheet->data, sheet->frame_bytes);
+    p->sheet = sheet;
+    p->img = img;
+    p->dsc.header.always_zero = 0;
+    p->dsc.header.w = sheet->w;
+    p->dsc.header.h = sheet->h;
+    p->dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    p->dsc.data_size = sheet->frame_bytes;
+    p->dsc.data = p->frame;
+    lv_img_set_src(img, &p->dsc);
+    p->timer = lv_timer_create(player_timer_cb, sheet->frame_ms, p);
+    lv_obj_add_event_cb(img, player_delete_cb, LV_EVENT_DELETE, p);
+    return true;
+}
+
+void ui_sprite_sheet_delete(ui_sprite_sheet_t *sheet)
+{
+    if (!sheet) {
+        return;
+    }
+    free(sheet->data);
+    lv_mem_free(sheet->frames);
+    lv_mem_free(sheet);
+}
+
+void ui_sprite_get_stats(const ui_sprite_sheet_t *sheet, ui_sprite_stats_t *stats)
+{
+    *stats = sheet->stats;
+}
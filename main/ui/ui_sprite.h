@@ -0,0 +1,65 @@
+#ifndef UI_SPRITE_H__
+#define UI_SPRITE_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UI_SPRITE_MIN_FRAME_MS  (40)    /* playback never runs faster, whatever the display does */
+
+/**
+ * Draw frame `index` into `px`: w * h pixels of LV_IMG_CF_TRUE_COLOR_ALPHA, cleared to
+ * transparent before the call. Called twice per frame while the sheet is built.
+ */
+typedef void (*ui_sprite_render_cb_t)(uint16_t index, uint8_t *px, void *user_data);
+
+typedef struct {
+    uint16_t w;
+    uint16_t h;
+    uint16_t frames;
+    uint16_t frame_ms;              /* raised to UI_SPRITE_MIN_FRAME_MS */
+    ui_sprite_render_cb_t render_cb;
+    void *user_data;
+} ui_sprite_config_t;
+
+typedef struct {
+    uint16_t frames;
+    uint16_t max_rects;             /* most sub-rectangles of a frame */
+    uint32_t sheet_bytes;           /* key frame and deltas */
+    uint32_t raw_bytes;             /* the same frames stored whole */
+    uint32_t played;
+    uint32_t skipped;               /* ticks while the image wasn't visible */
+    uint32_t inv_px;                /* area invalidated by the played frames */
+} ui_sprite_stats_t;
+
+typedef struct _ui_sprite_sheet_t ui_sprite_sheet_t;
+
+/**
+ * Render all frames once and keep frame 0 plus, per frame, the 8x8 tiles that differ from
+ * the frame before, merged into sub-rectangles along each tile row.
+ * @return NULL if out of memory or `frames` is 0
+ */
+ui_sprite_sheet_t *ui_sprite_sheet_create(const ui_sprite_config_t *config);
+
+/**
+ * Show `sheet` in the lv_img `img` and loop it until `img` is deleted. Each frame only copies
+ * its sub-rectangles and invalidates their bounding box; nothing is done while `img` is hidden.
+ * Several images can play the same sheet.
+ * @return false if out of memory for the shown frame, `img` is left as it was
+ */
+bool ui_sprite_play(lv_obj_t *img, ui_sprite_sheet_t *sheet);
+
+/**
+ * Free `sheet` once the images playing it are deleted.
+ */
+void ui_sprite_sheet_delete(ui_sprite_sheet_t *sheet);
+
+void ui_sprite_get_stats(const ui_sprite_sheet_t *sheet, ui_sprite_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
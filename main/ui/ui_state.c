@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include "lvgl.h"
+#include "dev_state.h"
+#include "ui_state.h"
+
+#define UI_STATE_MAX_BINDINGS   (8)
+#define UI_STATE_POLL_MS        (50)
+
+typedef struct {
+    lv_obj_t *obj;
+    dev_state_id_t id;
+    ui_state_set_cb_t set_cb;
+} binding_t;
+
+static binding_t bindings[UI_STATE_MAX_BINDINGS];
+static dev_state_sub_t sub;
+
+static void poll_timer_cb(lv_timer_t *t)
+{
+    uint32_t changed = dev_state_take_changes(&sub);
+    if (!changed) {
+        return;
+    }
+
+    dev_state_t state;
+    dev_state_read(&state);
+    for (int i = 0; i < UI_STATE_MAX_BINDINGS; i++) {
+        binding_t *b = &bindings[i];
+        if (b->obj && (changed & DEV_STATE_BIT(b->id))) {
+            b->set_cb(b->obj, state.v[b->id]);
+        }
+    }
+}
+
+static void binding_event_cb(lv_event_t *e)
+{
+    binding_t *b = lv_event_get_user_data(e);
+    lv_obj_t *obj = lv_event_get_target(e);
+
+    if (LV_EVENT_DELETE == lv_event_get_code(e)) {
+        b->obj = NULL;
+    } else if (lv_obj_check_type(obj, &lv_colorwheel_class)) {
+        dev_state_set(b->id, lv_colorwheel_get_hsv(obj).h);
+    } else {
+        dev_state_set(b->id, lv_arc_get_value(obj));
+    }
+}
+
+static void value_set_cb(lv_obj_t *obj, int16_t value)
+{
+    if (lv_obj_check_type(obj, &lv_colorwheel_class)) {
+        lv_color_hsv_t hsv = lv_colorwheel_get_hsv(obj);
+        if (hsv.h == value) {
+            return;
+        }
+        hsv.h = value;
+        lv_colorwheel_set_hsv(obj, hsv);
+    } else {
+        if (lv_arc_get_value(obj) == value) {
+            return;
+        }
+        lv_arc_set_value(obj, value);
+    }
+    lv_event_send(obj, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+void ui_state_init(void)
+{
+    /* changes made by the UI itself show up here too, set_cb has to tolerate its own value */
+    dev_state_subscribe(&sub, DEV_STATE_ALL, NULL);
+    lv_timer_create(poll_timer_cb, UI_STATE_POLL_MS, NULL);
+}
+
+void ui_state_bind(lv_obj_t *obj, dev_state_id_t id, ui_state_set_cb_t set_cb)
+{
+    binding_t *b = NULL;
+    for (int i = 0; i < UI_STATE_MAX_BINDINGS; i++) {
+        if (!bindings[i].obj) {
+            b = &bindings[i];
+            break;
+        }
+    }
+    if (!b) {
+        LV_LOG_WARN("no free state binding");
+        return;
+    }
+
+    b->obj = obj;
+    b->id = id;
+    b->set_cb = set_cb;
+    lv_obj_add_event_cb(obj, binding_event_cb, LV_EVENT_DELETE, b);
+    set_cb(obj, dev_state_get(id));
+}
+
+void ui_state_bind_value(lv_obj_t *obj, dev_state_id_t id)
+{
+    ui_state_bind(obj, id, value_set_cb);
+    binding_t *b = lv_obj_get_event_user_data(obj, binding_event_cb);
+    if (b) {
+        lv_obj_add_event_cb(obj, binding_event_cb, LV_EVENT_VALUE_CHANGED, b);
+    }
+}
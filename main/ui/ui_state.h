@@ -0,0 +1,34 @@
+#ifndef UI_STATE_H__
+#define UI_STATE_H__
+
+#include "lvgl.h"
+#include "dev_state.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*ui_state_set_cb_t)(lv_obj_t *obj, int16_t value);
+
+/**
+ * Subscribe the UI to the device state and start polling it from the LVGL task.
+ */
+void ui_state_init(void);
+
+/**
+ * Show the value `id` on `obj`: `set_cb` runs now and whenever another task changes the value,
+ * until `obj` is deleted. Writing user changes back is up to the caller.
+ */
+void ui_state_bind(lv_obj_t *obj, dev_state_id_t id, ui_state_set_cb_t set_cb);
+
+/**
+ * Bind an arc (value) or a colorwheel (hue) both ways. Changes from the store are applied and
+ * sent as LV_EVENT_VALUE_CHANGED, so the handlers of `obj` update whatever depends on it.
+ */
+void ui_state_bind_value(lv_obj_t *obj, dev_state_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include "lvgl.h"
+#include "ui_theme.h"
+
+/* Same palette as the dark default theme so the screens keep their look */
+#define COLOR_SCR       lv_color_hex(0x15171A)
+#define COLOR_CARD      lv_color_hex(0x282b30)
+#define COLOR_GREY      lv_color_hex(0x2f3237)
+#define COLOR_TEXT      lv_palette_lighten(LV_PALETTE_GREY, 5)
+
+typedef struct {
+    lv_style_t scr;
+    lv_style_t card;
+    lv_style_t pad_normal;
+    lv_style_t btn;
+    lv_style_t circle;
+    lv_style_t arc;
+    lv_style_t arc_indic;
+    lv_style_t knob;
+    lv_style_t focus;
+    lv_style_t edit;
+} theme_styles_t;
+
+static lv_theme_t theme;
+static theme_styles_t styles;
+static bool inited;
+
+static void style_init(lv_disp_t *disp)
+{
+    lv_style_init(&styles.scr);
+    lv_style_set_bg_opa(&styles.scr, LV_OPA_COVER);
+    lv_style_set_bg_color(&styles.scr, COLOR_SCR);
+    lv_style_set_text_color(&styles.scr, COLOR_TEXT);
+
+    lv_style_init(&styles.card);
+    lv_style_set_bg_opa(&styles.card, LV_OPA_COVER);
+    lv_style_set_bg_color(&styles.card, COLOR_CARD);
+    lv_style_set_border_color(&styles.card, COLOR_GREY);
+    lv_style_set_border_width(&styles.card, lv_disp_dpx(disp, 2));
+    lv_style_set_radius(&styles.card, lv_disp_dpx(disp, 12));
+    lv_style_set_pad_all(&styles.card, lv_disp_dpx(disp, 16));
+    lv_style_set_text_color(&styles.card, COLOR_TEXT);
+
+    lv_style_init(&styles.pad_normal);
+    lv_style_set_pad_all(&styles.pad_normal, lv_disp_dpx(disp, 16));
+
+    lv_style_init(&styles.btn);
+    lv_style_set_bg_opa(&styles.btn, LV_OPA_COVER);
+    lv_style_set_bg_color(&styles.btn, theme.color_primary);
+    lv_style_set_radius(&styles.btn, lv_disp_dpx(disp, 12));
+    lv_style_set_text_color(&styles.btn, lv_color_white());
+
+    lv_style_init(&styles.circle);
+    lv_style_set_radius(&styles.circle, LV_RADIUS_CIRCLE);
+
+    lv_style_init(&styles.arc);
+    lv_style_set_arc_width(&styles.arc, lv_disp_dpx(disp, 15));
+    lv_style_set_arc_color(&styles.arc, COLOR_GREY);
+    lv_style_set_arc_rounded(&styles.arc, true);
+
+    lv_style_init(&styles.arc_indic);
+    lv_style_set_arc_width(&styles.arc_indic, lv_disp_dpx(disp, 15));
+    lv_style_set_arc_color(&styles.arc_indic, theme.color_primary);
+    lv_style_set_arc_rounded(&styles.arc_indic, true);
+
+    lv_style_init(&styles.knob);
+    lv_style_set_bg_opa(&styles.knob, LV_OPA_COVER);
+    lv_style_set_bg_color(&styles.knob, theme.color_primary);
+    lv_style_set_radius(&styles.knob, LV_RADIUS_CIRCLE);
+    lv_style_set_pad_all(&styles.knob, lv_disp_dpx(disp, 6));
+
+    /* opaque and unpadded: the ring is a plain fill along the object's edge, no blending */
+    lv_style_init(&styles.focus);
+    lv_style_set_outline_width(&styles.focus, 2);
+    lv_style_set_outline_color(&styles.focus, lv_palette_main(LV_PALETTE_LIGHT_BLUE));
+    lv_style_set_outline_opa(&styles.focus, LV_OPA_COVER);
+
+    lv_style_init(&styles.edit);
+    lv_style_set_outline_color(&styles.edit, lv_palette_main(LV_PALETTE_YELLOW));
+}
+
+static void theme_apply(lv_theme_t *th, lv_obj_t *obj)
+{
+    LV_UNUSED(th);
+    lv_obj_t *parent = lv_obj_get_parent(obj);
+
+    if (parent == NULL) {
+        lv_obj_add_style(obj, &styles.scr, 0);
+        return;
+    }
+
+    if (lv_obj_check_type(obj, &lv_obj_class)) {
+#if LV_USE_TABVIEW
+        /* the tabview's content keeps the tabview background, the tabs only need padding */
+        if (lv_obj_check_type(parent, &lv_tabview_class)) {
+            return;
+        }
+        lv_obj_t *grand = lv_obj_get_parent(parent);
+        if (grand && lv_obj_check_type(grand, &lv_tabview_class)) {
+            lv_obj_add_style(obj, &styles.pad_normal, 0);
+            return;
+        }
+#endif
+        lv_obj_add_style(obj, &styles.card, 0);
+        lv_obj_add_style(obj, &styles.focus, LV_STATE_FOCUS_KEY);
+        lv_obj_add_style(obj, &styles.edit, LV_STATE_EDITED);
+    }
+#if LV_USE_BTN
+    else if (lv_obj_check_type(obj, &lv_btn_class)) {
+        lv_obj_add_style(obj, &styles.btn, 0);
+        lv_obj_add_style(obj, &styles.focus, LV_STATE_FOCUS_KEY);
+        lv_obj_add_style(obj, &styles.edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_ARC
+    else if (lv_obj_check_type(obj, &lv_arc_class)) {
+        lv_obj_add_style(obj, &styles.arc, 0);
+        lv_obj_add_style(obj, &styles.arc_indic, LV_PART_INDICATOR);
+        lv_obj_add_style(obj, &styles.knob, LV_PART_KNOB);
+        lv_obj_add_style(obj, &styles.focus, LV_PART_KNOB | LV_STATE_FOCUS_KEY);
+        lv_obj_add_style(obj, &styles.edit, LV_PART_KNOB | LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_COLORWHEEL
+    else if (lv_obj_check_type(obj, &lv_colorwheel_class)) {
+        lv_obj_add_style(obj, &styles.arc, 0);
+        lv_obj_add_style(obj, &styles.knob, LV_PART_KNOB);
+        lv_obj_add_style(obj, &styles.focus, LV_PART_KNOB | LV_STATE_FOCUS_KEY);
+        lv_obj_add_style(obj, &styles.edit, LV_PART_KNOB | LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_METER
+    else if (lv_obj_check_type(obj, &lv_meter_class)) {
+        lv_obj_add_style(obj, &styles.card, 0);
+        lv_obj_add_style(obj, &styles.circle, 0);
+        lv_obj_add_style(obj, &styles.knob, LV_PART_INDICATOR);
+    }
+#endif
+#if LV_USE_TABVIEW
+    else if (lv_obj_check_type(obj, &lv_tabview_class)) {
+        lv_obj_add_style(obj, &styles.scr, 0);
+    }
+#endif
+    /* labels and images inherit everything they need from their parent */
+}
+
+lv_theme_t *ui_theme_init(lv_disp_t *disp)
+{
+    if (inited) {
+        return &theme;
+    }
+
+    lv_memset_00(&theme, sizeof(theme));
+    theme.disp = disp;
+    theme.color_primary = lv_palette_main(LV_PALETTE_BLUE);
+    theme.color_secondary = lv_palette_main(LV_PALETTE_LIGHT_BLUE);
+    theme.font_small = LV_FONT_DEFAULT;
+    theme.font_normal = LV_FONT_DEFAULT;
+    theme.font_large = LV_FONT_DEFAULT;
+    theme.apply_cb = theme_apply;
+
+    style_init(disp);
+    inited = true;
+    return &theme;
+}
+
+static lv_obj_tree_walk_res_t usage_cb(lv_obj_t *obj, void *user_data)
+{
+    ui_theme_style_usage_t *usage = user_data;
+
+    usage->objs++;
+    usage->style_refs += obj->style_cnt;
+    usage->bytes += obj->style_cnt * sizeof(_lv_obj_style_t);
+    for (uint32_t i = 0; i < obj->style_cnt; i++) {
+        const _lv_obj_style_t *s = &obj->styles[i];
+        if (!s->is_local && !s->is_trans) {
+            continue;
+        }
+        /* local and transition styles are allocated per object, a single property lives inline */
+        uint8_t cnt = s->style->prop_cnt;
+        usage->local_props += cnt;
+        usage->bytes += sizeof(lv_style_t);
+        if (cnt > 1) {
+            usage->bytes += cnt * (sizeof(lv_style_value_t) + sizeof(lv_style_prop_t));
+        }
+    }
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+void ui_theme_get_style_usage(lv_obj_t *root, ui_theme_style_usage_t *usage)
+{
+    lv_memset_00(usage, sizeof(ui_theme_style_usage_t));
+    lv_obj_tree_walk(root, usage_cb, usage);
+}
@@ -0,0 +1,32 @@
+#ifndef UI_THEME_H__
+#define UI_THEME_H__
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t objs;
+    uint32_t style_refs;    /* style slots of all objects, shared and local */
+    uint32_t local_props;   /* properties held in per object local styles */
+    uint32_t bytes;         /* heap used by the slots and the local styles */
+} ui_theme_style_usage_t;
+
+/**
+ * Theme for this round, encoder driven display: dark flat styles, no transitions, no press
+ * grow and a solid 2px outline as focus ring.
+ */
+lv_theme_t *ui_theme_init(lv_disp_t *disp);
+
+/**
+ * Sum up the style data attached to `root` and its children.
+ */
+void ui_theme_get_style_usage(lv_obj_t *root, ui_theme_style_usage_t *usage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,15 +2,30 @@
 #include <stdio.h>
 #include <time.h>
 #include "lvgl.h"
+#include "lvgl_port.h"
+#include "dev_state.h"
 #include "ui.h"
 #include "ui_washing.h"
+#include "ui_baked_anim.h"
+#include "ui_asset_pool.h"
+#include "ui_img_runs.h"
+#include "ui_state.h"
 #include "src/misc/lv_math.h"
 
+/* Play the bubble/wave loop from a recorded clip instead of compositing it every frame */
+#define WASHING_BAKED_ANIM      1
+#define WASHING_LOOP_MS         4000
+#define WASHING_FRAME_MS        40
+
 static lv_obj_t  *page;
 static ret_cb_t return_callback;
 static lv_obj_t *img_bg;
 static lv_obj_t *img_wave1, *img_wave2;
 static lv_coord_t img_wave1_x, img_wave2_x;
+static lv_obj_t *img_bub1, *img_bub2;
+static lv_coord_t img_bub1_y, img_bub2_y;
+static ui_baked_anim_t *baked_anim;
+static bool live_loop;
 
 LV_IMG_DECLARE(img_washing_bg);
 LV_IMG_DECLARE(img_washing_wave1);
@@ -28,6 +43,17 @@ static const lv_img_dsc_t *wash_funcs[FUNC_NUM] = {
     &img_washing_underwear,
 };
 
+/* composited every frame while the loop runs live, hottest first */
+static const lv_img_dsc_t *const hot_assets[] = {
+    &img_washing_bubble2,
+    &img_washing_bubble1,
+    &img_washing_wave1,
+    &img_washing_wave2,
+    &img_washing_stand,
+    &img_washing_shirt,
+    &img_washing_underwear,
+};
+
 static lv_obj_t *img_funcs[FUNC_NUM];
 static int16_t func_index = 0;
 static int16_t last_theta = 0;
@@ -60,6 +86,23 @@ static void func_anim_ready_cb(lv_anim_t *a)
 {
     int dir = (int)lv_anim_get_user_data(a);
     func_index += dir;
+    dev_state_set(DEV_STATE_WASH_MODE, func_index);
+}
+
+static void wash_mode_set_cb(lv_obj_t *obj, int16_t value)
+{
+    value = LV_CLAMP(0, value, FUNC_NUM - 1);
+    if (value == func_index) {
+        return;
+    }
+    /* a programme picked elsewhere wins over a turn still animating */
+    lv_anim_del((void *)1, func_anim_cb);
+    lv_anim_del((void *)-1, func_anim_cb);
+    func_index = value;
+    for (size_t i = 0; i < FUNC_NUM; i++) {
+        lv_obj_set_style_img_recolor_opa(img_funcs[i], LV_OPA_TRANSP, 0);
+    }
+    func_anim_cb((void *)0, 0);
 }
 
 static void washing_event_cb(lv_event_t *e)
@@ -104,10 +147,9 @@ static void washing_event_cb(lv_event_t *e)
 static void bub1_anim_cb(void *args, int32_t v)
 {
     lv_obj_t *img_bub = (lv_obj_t *)args;
-    lv_coord_t y = lv_obj_get_y_aligned(img_bub);
     int opa = 0;
-    if (y > -60) {
-        opa = 255 * (60 + y) / 60;
+    if (v > -60) {
+        opa = 255 * (60 + v) / 60;
     }
     lv_obj_set_style_img_opa(img_bub, opa, 0);
     lv_obj_set_y(img_bub, v);
@@ -119,6 +161,93 @@ static void wave_anim_cb(void *args, int32_t v)
     lv_obj_set_x(img_wave2, img_wave2_x - LV_ABS(v));
 }
 
+static int32_t loop_anim_value(int32_t start, int32_t end, uint32_t period, uint32_t t)
+{
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_values(&a, start, end);
+    lv_anim_set_time(&a, period);
+    a.act_time = t % period;
+    return lv_anim_path_ease_in_out(&a);
+}
+
+static void washing_loop_pose(uint32_t t_ms, void *user_data)
+{
+    /* periods divide WASHING_LOOP_MS so the recorded loop closes on itself */
+    bub1_anim_cb(img_bub1, loop_anim_value(img_bub1_y, img_bub1_y - 90, WASHING_LOOP_MS / 2, t_ms));
+    bub1_anim_cb(img_bub2, loop_anim_value(img_bub2_y, img_bub2_y - 90, WASHING_LOOP_MS / 2, t_ms + WASHING_LOOP_MS / 4));
+    wave_anim_cb(NULL, loop_anim_value(-40, 40, WASHING_LOOP_MS, t_ms));
+}
+
+static void live_loop_start(void)
+{
+    lv_anim_t a1;
+    lv_anim_init(&a1);
+    lv_anim_set_var(&a1, img_bub1);
+    lv_anim_set_delay(&a1, 0);
+    lv_anim_set_values(&a1, img_bub1_y, img_bub1_y - 90);
+    lv_anim_set_exec_cb(&a1, bub1_anim_cb);
+    lv_anim_set_path_cb(&a1, lv_anim_path_ease_in_out);
+    lv_anim_set_time(&a1, lv_rand(1800, 2300));
+    lv_anim_set_repeat_count(&a1, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_start(&a1);
+
+    lv_anim_t a2;
+    lv_anim_init(&a2);
+    lv_anim_set_var(&a2, img_bub2);
+    lv_anim_set_delay(&a2, 0);
+    lv_anim_set_values(&a2, img_bub2_y, img_bub2_y - 90);
+    lv_anim_set_exec_cb(&a2, bub1_anim_cb);
+    lv_anim_set_path_cb(&a2, lv_anim_path_ease_in_out);
+    lv_anim_set_time(&a2, lv_rand(2000, 2800));
+    lv_anim_set_repeat_count(&a2, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_start(&a2);
+
+    lv_anim_t a3;
+    lv_anim_init(&a3);
+    lv_anim_set_var(&a3, img_wave1);
+    lv_anim_set_delay(&a3, 0);
+    lv_anim_set_values(&a3, -40, 40);
+    lv_anim_set_exec_cb(&a3, wave_anim_cb);
+    lv_anim_set_path_cb(&a3, lv_anim_path_ease_in_out);
+    lv_anim_set_time(&a3, lv_rand(3200, 4000));
+    lv_anim_set_repeat_count(&a3, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_start(&a3);
+    lvgl_port_lowres_hold();
+    live_loop = true;
+}
+
+/* a recording slice posed the objects, the running animations put them back */
+static void live_loop_restore(void *user_data)
+{
+    static const struct {
+        lv_obj_t **var;
+        lv_anim_exec_xcb_t exec_cb;
+    } anims[] = {
+        {&img_bub1, bub1_anim_cb},
+        {&img_bub2, bub1_anim_cb},
+        {&img_wave1, wave_anim_cb},
+    };
+    for (size_t i = 0; i < sizeof(anims) / sizeof(anims[0]); i++) {
+        lv_anim_t *a = lv_anim_get(*anims[i].var, anims[i].exec_cb);
+        if (a) {
+            a->exec_cb(a->var, a->path_cb(a));
+        }
+    }
+}
+
+static void live_loop_stop(void *user_data)
+{
+    if (!live_loop) {
+        return;
+    }
+    lv_anim_del(img_bub1, bub1_anim_cb);
+    lv_anim_del(img_bub2, bub1_anim_cb);
+    lv_anim_del(img_wave1, wave_anim_cb);
+    lvgl_port_lowres_release();
+    live_loop = false;
+}
+
 static void mask_event_cb(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
@@ -162,7 +291,15 @@ void ui_washing_init(ret_cb_t ret_cb)
     lv_obj_center(page);
     lv_obj_refr_size(page);
 
-    img_bg = lv_img_create(page);
+    /* mostly opaque inside with soft edges, blended only at the edges */
+    ui_img_runs_encode(&img_washing_bg, "washing_bg");
+    ui_img_runs_encode(&img_washing_bubble1, "bubble1");
+    ui_img_runs_encode(&img_washing_bubble2, "bubble2");
+    ui_img_runs_encode(&img_washing_stand, "stand");
+    ui_img_runs_encode(&img_washing_shirt, "shirt");
+    ui_img_runs_encode(&img_washing_underwear, "underwear");
+
+    img_bg = ui_img_runs_create(page);
     lv_img_set_src(img_bg, &img_washing_bg);
     lv_obj_align(img_bg, LV_ALIGN_LEFT_MID, -7, 0);
     img_wave1 = lv_img_create(img_bg);
@@ -171,10 +308,10 @@ void ui_washing_init(ret_cb_t ret_cb)
     img_wave2 = lv_img_create(img_bg);
     lv_img_set_src(img_wave2, &img_washing_wave2);
     lv_obj_align(img_wave2, LV_ALIGN_BOTTOM_MID, 20, 10);
-    lv_obj_t *img_bub1 = lv_img_create(img_bg);
+    img_bub1 = ui_img_runs_create(img_bg);
     lv_img_set_src(img_bub1, &img_washing_bubble1);
     lv_obj_center(img_bub1);
-    lv_obj_t *img_bub2 = lv_img_create(img_bg);
+    img_bub2 = ui_img_runs_create(img_bg);
     lv_img_set_src(img_bub2, &img_washing_bubble2);
     lv_obj_center(img_bub2);
     lv_obj_add_event_cb(img_wave1, mask_event_cb, LV_EVENT_ALL, NULL);
@@ -183,11 +320,13 @@ void ui_washing_init(ret_cb_t ret_cb)
     int16_t x, y;
     for (size_t i = 0; i < FUNC_NUM; i++) {
         arc_path_by_theta(i * 45, &x, &y);
-        img_funcs[i] = lv_img_create(page);
+        img_funcs[i] = ui_img_runs_create(page);
         lv_img_set_src(img_funcs[i], wash_funcs[i]);
         lv_obj_align(img_funcs[i], LV_ALIGN_CENTER, x, y);
     }
+    func_index = LV_CLAMP(0, dev_state_get(DEV_STATE_WASH_MODE), FUNC_NUM - 1);
     func_anim_cb((void*)0, 0);
+    ui_state_bind(page, DEV_STATE_WASH_MODE, wash_mode_set_cb);
 
     lv_obj_t *label1 = lv_label_create(page);
     lv_obj_set_style_text_font(label1, &lv_font_montserrat_16, 0);
@@ -197,51 +336,41 @@ void ui_washing_init(ret_cb_t ret_cb)
     lv_obj_set_style_text_align(label1, LV_TEXT_ALIGN_CENTER, 0);
     lv_obj_align(label1, LV_ALIGN_CENTER, 60, 27);
 
-    lv_anim_t a1;
-    lv_anim_init(&a1);
-    lv_anim_set_var(&a1, img_bub1);
-    lv_anim_set_delay(&a1, 0);
-    lv_anim_set_values(&a1, lv_obj_get_y_aligned(img_bub1), lv_obj_get_y_aligned(img_bub1) - 90);
-    lv_anim_set_exec_cb(&a1, bub1_anim_cb);
-    lv_anim_set_path_cb(&a1, lv_anim_path_ease_in_out);
-    lv_anim_set_time(&a1, lv_rand(1800, 2300));
-    lv_anim_set_repeat_count(&a1, LV_ANIM_REPEAT_INFINITE);
-    lv_anim_start(&a1);
-
-    lv_anim_t a2;
-    lv_anim_init(&a2);
-    lv_anim_set_var(&a2, img_bub2);
-    lv_anim_set_delay(&a2, 0);
-    lv_anim_set_values(&a2, lv_obj_get_y_aligned(img_bub2), lv_obj_get_y_aligned(img_bub2) - 90);
-    lv_anim_set_exec_cb(&a2, bub1_anim_cb);
-    lv_anim_set_path_cb(&a2, lv_anim_path_ease_in_out);
-    lv_anim_set_time(&a2, lv_rand(2000, 2800));
-    lv_anim_set_repeat_count(&a2, LV_ANIM_REPEAT_INFINITE);
-    lv_anim_start(&a2);
-
+    img_bub1_y = lv_obj_get_y_aligned(img_bub1);
+    img_bub2_y = lv_obj_get_y_aligned(img_bub2);
     img_wave1_x = lv_obj_get_x_aligned(img_wave1);
     img_wave2_x = lv_obj_get_x_aligned(img_wave2);
-    lv_anim_t a3;
-    lv_anim_init(&a3);
-    lv_anim_set_var(&a3, img_wave1);
-    lv_anim_set_delay(&a3, 0);
-    lv_anim_set_values(&a3, -40, 40);
-    lv_anim_set_exec_cb(&a3, wave_anim_cb);
-    lv_anim_set_path_cb(&a3, lv_anim_path_ease_in_out);
-    lv_anim_set_time(&a3, lv_rand(3200, 4000));
-    lv_anim_set_repeat_count(&a3, LV_ANIM_REPEAT_INFINITE);
-    lv_anim_start(&a3);
 
+    /* until the clip plays, also while it is being recorded */
+    live_loop_start();
+#if WASHING_BAKED_ANIM
+    /* a recording needs two frames, more than the page reserve: the copies of the previous page go first */
+    ui_asset_pool_activate(NULL, 0);
+    ui_baked_anim_config_t baked_config = {
+        .obj = img_bg,
+        .loop_ms = WASHING_LOOP_MS,
+        .frame_ms = WASHING_FRAME_MS,
+        .pose_cb = washing_loop_pose,
+        .restore_cb = live_loop_restore,
+        .ready_cb = live_loop_stop,
+        .partition_label = "anim",
+    };
+    baked_anim = ui_baked_anim_create(&baked_config);
+#endif
     lv_obj_add_event_cb(page, washing_event_cb, LV_EVENT_FOCUSED, NULL);
     lv_obj_add_event_cb(page, washing_event_cb, LV_EVENT_LONG_PRESSED, NULL);
     lv_obj_add_event_cb(page, washing_event_cb, LV_EVENT_KEY, NULL);
     ui_add_obj_to_encoder_group(page);
+    ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
 }
 
 void ui_washing_delete(void)
 {
     if (page) {
         ui_remove_all_objs_from_encoder_group();
+        ui_baked_anim_delete(baked_anim);
+        baked_anim = NULL;
+        live_loop_stop(NULL);
         lv_anim_del_all();
         lv_obj_del(page);
         page = NULL;
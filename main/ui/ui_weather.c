@@ -1,14 +1,22 @@
 #include "lvgl.h"
 #include <stdio.h>
+#include <string.h>
 #include "esp_system.h"
 #ifdef ESP_IDF_VERSION
 #include "esp_log.h"
 #endif
+#include "lvgl_port.h"
 #include "ui.h"
+#include "ui_asset_pool.h"
+#include "ui_desc.h"
+#include "ui_sprite.h"
 #include "ui_weather.h"
 
 static lv_obj_t *page;
 static ret_cb_t return_callback;
+static ui_desc_builder_t builder;
+static bool preloading;
+static ui_sprite_sheet_t *sun_sheet;
 
 static void weather_event_cb(lv_event_t *e)
 {
@@ -26,6 +34,140 @@ static void weather_event_cb(lv_event_t *e)
     }
 }
 
+LV_IMG_DECLARE(img_weather);
+LV_IMG_DECLARE(img_cloudy);
+LV_FONT_DECLARE(font_cn_48);
+LV_FONT_DECLARE(font_cn_12);
+
+/* "Mostly sunny": the rays around the cloud light up one after the other */
+#define SUN_PAD         (6)
+#define SUN_RAYS        (8)
+#define SUN_RAY_R1      (23)
+#define SUN_RAY_R2      (29)
+#define SUN_FRAME_MS    (120)
+#define SUN_SIZE        (48 + 2 * SUN_PAD)  /* img_cloudy with the rays around it */
+
+static void sun_put(uint8_t *px, uint16_t w, uint16_t h, lv_coord_t x, lv_coord_t y, lv_color_t c, lv_opa_t opa)
+{
+    if (x < 0 || y < 0 || x >= w || y >= h) {
+        return;
+    }
+    uint8_t *p = px + ((uint32_t)y * w + x) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    memcpy(p, &c, sizeof(c));
+    p[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = opa;
+}
+
+static void sun_render_cb(uint16_t index, uint8_t *px, void *user_data)
+{
+    const lv_img_dsc_t *cloud = user_data;
+    uint16_t cw = cloud->header.w;
+    uint16_t w = cw + 2 * SUN_PAD;
+    uint16_t h = cloud->header.h + 2 * SUN_PAD;
+    lv_color_t color = lv_palette_main(LV_PALETTE_AMBER);
+
+    for (int k = 0; k < SUN_RAYS; k++) {
+        int16_t angle = k * 360 / SUN_RAYS;
+        lv_opa_t opa = (k == index) ? LV_OPA_COVER : LV_OPA_40;
+        for (int r = SUN_RAY_R1; r <= SUN_RAY_R2; r++) {
+            lv_coord_t x = w / 2 + ((r * lv_trigo_cos(angle)) >> LV_TRIGO_SHIFT);
+            lv_coord_t y = h / 2 + ((r * lv_trigo_sin(angle)) >> LV_TRIGO_SHIFT);
+            sun_put(px, w, h, x, y, color, opa);
+            sun_put(px, w, h, x + 1, y, color, opa);
+            sun_put(px, w, h, x, y + 1, color, opa);
+            sun_put(px, w, h, x + 1, y + 1, color, opa);
+        }
+    }
+
+    /* the cloud goes over the rays */
+    for (uint16_t y = 0; y < cloud->header.h; y++) {
+        for (uint16_t x = 0; x < cw; x++) {
+            const uint8_t *s = cloud->data + ((uint32_t)y * cw + x) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+            uint8_t *d = px + ((uint32_t)(y + SUN_PAD) * w + x + SUN_PAD) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+            lv_opa_t sa = s[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+            lv_opa_t da = d[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+            if (sa <= LV_OPA_MIN) {
+                continue;
+            }
+            if (sa >= LV_OPA_MAX || da <= LV_OPA_MIN) {
+                memcpy(d, s, LV_IMG_PX_SIZE_ALPHA_BYTE);
+                continue;
+            }
+            lv_opa_t oa = sa + da * (255 - sa) / 255;
+            lv_color_t sc, dc;
+            memcpy(&sc, s, sizeof(sc));
+            memcpy(&dc, d, sizeof(dc));
+            dc = lv_color_mix(sc, dc, sa * 255 / oa);
+            memcpy(d, &dc, sizeof(dc));
+            d[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = oa;
+        }
+    }
+}
+
+enum {
+    OBJ_PAGE,
+    OBJ_BG,
+    OBJ_CITY,
+    OBJ_TEMPERATURE,
+    OBJ_ICON,
+    OBJ_STATE,
+    OBJ_NUM,
+};
+
+static const ui_desc_style_t page_styles[] = {
+    UI_DESC_NUM(LV_STYLE_BORDER_WIDTH, 0, 0),
+    UI_DESC_NUM(LV_STYLE_RADIUS, 0, 0),
+};
+
+static const ui_desc_style_t bg_styles[] = {
+    UI_DESC_NUM(LV_STYLE_IMG_OPA, LV_OPA_80, 0),
+};
+
+static const ui_desc_style_t city_styles[] = {
+    UI_DESC_PTR(LV_STYLE_TEXT_FONT, &lv_font_montserrat_20, 0),
+    UI_DESC_NUM(LV_STYLE_TEXT_ALIGN, LV_TEXT_ALIGN_CENTER, 0),
+};
+
+static const ui_desc_digits_t temperature_digits = {
+    .font = &font_cn_48, .charset = "0123456789-℃", .cells = 4,
+};
+
+static const ui_desc_style_t state_styles[] = {
+    UI_DESC_PTR(LV_STYLE_TEXT_FONT, &font_cn_12, 0),
+    UI_DESC_NUM(LV_STYLE_TEXT_ALIGN, LV_TEXT_ALIGN_CENTER, 0),
+};
+
+static lv_obj_t *objs[OBJ_NUM];
+
+static const ui_desc_obj_t weather_desc[OBJ_NUM] = {
+    [OBJ_PAGE] = {
+        .type = UI_DESC_OBJ, .parent = -1, .align_to = -1, .align = LV_ALIGN_CENTER,
+        .size_mode = UI_DESC_SIZE_PARENT, UI_DESC_STYLES(page_styles), .clear_flags = LV_OBJ_FLAG_SCROLLABLE,
+    },
+    [OBJ_BG] = {
+        .type = UI_DESC_IMG, .parent = OBJ_PAGE, .align_to = -1, .align = LV_ALIGN_CENTER,
+        .src = &img_weather, UI_DESC_STYLES(bg_styles),
+    },
+    [OBJ_CITY] = {
+        .type = UI_DESC_LABEL, .parent = OBJ_BG, .align_to = -1, .align = LV_ALIGN_CENTER, .y_ofs = -70,
+        .w = LV_SIZE_CONTENT, .h = LV_SIZE_CONTENT, .text = "Shang hai", UI_DESC_STYLES(city_styles),
+        .anim_dy = -20, .anim_time = 400,
+    },
+    [OBJ_TEMPERATURE] = {
+        .type = UI_DESC_DIGITS, .parent = OBJ_BG, .align_to = OBJ_CITY, .align = LV_ALIGN_OUT_BOTTOM_MID, .y_ofs = 5,
+        .text = "24℃", .digits = &temperature_digits,
+    },
+    [OBJ_ICON] = {
+        /* sized for the sprite frame, so the state label is laid out below the rays */
+        .type = UI_DESC_IMG, .parent = OBJ_BG, .align_to = OBJ_TEMPERATURE, .align = LV_ALIGN_OUT_BOTTOM_MID,
+        .y_ofs = 8 - SUN_PAD, .w = SUN_SIZE, .h = SUN_SIZE, .src = &img_cloudy, .anim_dy = 30, .anim_time = 400,
+    },
+    [OBJ_STATE] = {
+        .type = UI_DESC_LABEL, .parent = OBJ_BG, .align_to = OBJ_ICON, .align = LV_ALIGN_OUT_BOTTOM_MID,
+        .w = 150, .text = "Mostly sunny\nMin:22℃ Max:28℃", UI_DESC_STYLES(state_styles),
+        .anim_dy = 40, .anim_time = 400,
+    },
+};
+
 void ui_weather_init(ret_cb_t ret_cb)
 {
     if (page) {
@@ -35,78 +177,61 @@ void ui_weather_init(ret_cb_t ret_cb)
 
     return_callback = ret_cb;
 
-    page = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(page, lv_obj_get_width(lv_obj_get_parent(page)), lv_obj_get_height(lv_obj_get_parent(page)));
-    lv_obj_set_style_border_width(page, 0, 0);
-    lv_obj_set_style_radius(page, 0, 0);
-    lv_obj_clear_flag(page, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_center(page);
-
-    LV_IMG_DECLARE(img_weather);
-    lv_obj_t *img = lv_img_create(page);
-    lv_img_set_src(img, &img_weather);
-    lv_obj_align(img, LV_ALIGN_CENTER, 0, 0);
-    lv_obj_set_style_img_opa(img, LV_OPA_80, 0);
-
-    lv_obj_t *label_city = lv_label_create(img);
-    lv_label_set_text(label_city, "Shang hai");
-    lv_obj_set_style_text_font(label_city, &lv_font_montserrat_20, 0);
-    lv_obj_set_size(label_city, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
-    lv_obj_set_style_text_align(label_city, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align(label_city, LV_ALIGN_CENTER, 0, -70);
-
-    lv_obj_t *label_temperature = lv_label_create(img);
-    lv_label_set_text(label_temperature, "24℃");
-    LV_FONT_DECLARE(font_cn_48);
-    lv_obj_set_style_text_font(label_temperature, &font_cn_48, 0);
-    lv_obj_set_size(label_temperature, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
-    lv_obj_set_style_text_align(label_temperature, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align_to(label_temperature, label_city, LV_ALIGN_OUT_BOTTOM_MID, 0, 5);
-
-    LV_IMG_DECLARE(img_cloudy);
-    lv_obj_t *img_icon = lv_img_create(img);
-    lv_img_set_src(img_icon, &img_cloudy);
-    lv_obj_align_to(img_icon, label_temperature, LV_ALIGN_OUT_BOTTOM_MID, 0, 8);
-
-    lv_obj_t *label_state = lv_label_create(img);
-    lv_label_set_text_fmt(label_state, "Mostly sunny\nMin:%02d℃ Max:%02d℃", 22, 28);
-    LV_FONT_DECLARE(font_cn_12);
-    lv_obj_set_style_text_font(label_state, &font_cn_12, 0);
-    lv_obj_set_width(label_state, 150);
-    lv_obj_set_style_text_align(label_state, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align_to(label_state, img_icon, LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
-
-    lv_anim_t a1;
-    lv_anim_init(&a1);
-    lv_anim_set_var(&a1, label_city);
-    lv_anim_set_values(&a1, lv_obj_get_y_aligned(label_city) - 20, lv_obj_get_y_aligned(label_city));
-    lv_anim_set_exec_cb(&a1, (lv_anim_exec_xcb_t)lv_obj_set_y);
-    lv_anim_set_path_cb(&a1, lv_anim_path_overshoot);
-    lv_anim_set_time(&a1, 400);
-    lv_anim_start(&a1);
-
-    lv_anim_t a2;
-    lv_anim_init(&a2);
-    lv_anim_set_var(&a2, img_icon);
-    lv_anim_set_values(&a2, lv_obj_get_y_aligned(img_icon) + 30, lv_obj_get_y_aligned(img_icon));
-    lv_anim_set_exec_cb(&a2, (lv_anim_exec_xcb_t)lv_obj_set_y);
-    lv_anim_set_path_cb(&a2, lv_anim_path_overshoot);
-    lv_anim_set_time(&a2, 400);
-    lv_anim_start(&a2);
-
-    lv_anim_t a3;
-    lv_anim_init(&a3);
-    lv_anim_set_var(&a3, label_state);
-    lv_anim_set_values(&a3, lv_obj_get_y_aligned(label_state) + 40, lv_obj_get_y_aligned(label_state));
-    lv_anim_set_exec_cb(&a3, (lv_anim_exec_xcb_t)lv_obj_set_y);
-    lv_anim_set_path_cb(&a3, lv_anim_path_overshoot);
-    lv_anim_set_time(&a3, 400);
-    lv_anim_start(&a3);
+    if (!preloading) {
+        ui_desc_build_begin(&builder, lv_scr_act(), weather_desc, OBJ_NUM, objs);
+    }
+    preloading = false;
+    page = ui_desc_build_finish(&builder);
 
     lv_obj_add_event_cb(page, weather_event_cb, LV_EVENT_FOCUSED, NULL);
     lv_obj_add_event_cb(page, weather_event_cb, LV_EVENT_LONG_PRESSED, NULL);
     ui_add_obj_to_encoder_group(page);
 
+    /* built per visit, the RAM goes back to the other pages when it's closed */
+    ui_sprite_config_t config = {
+        .w = SUN_SIZE,
+        .h = SUN_SIZE,
+        .frames = SUN_RAYS,
+        .frame_ms = SUN_FRAME_MS,
+        .render_cb = sun_render_cb,
+        .user_data = (void *)&img_cloudy,
+    };
+    sun_sheet = ui_sprite_sheet_create(&config);
+    if (sun_sheet && !ui_sprite_play(objs[OBJ_ICON], sun_sheet)) {
+        ui_sprite_sheet_delete(sun_sheet);
+        sun_sheet = NULL;
+    }
+    if (sun_sheet) {
+        /* the icon plays from RAM, nothing is worth a pool copy */
+        ui_asset_pool_activate(NULL, 0);
+    } else {
+        /* the plain cloud in the middle of the frame, lv_img would tile it otherwise */
+        lv_obj_set_style_pad_all(objs[OBJ_ICON], SUN_PAD, 0);
+        static const lv_img_dsc_t *const hot_assets[] = {&img_cloudy};
+        ui_asset_pool_activate(hot_assets, sizeof(hot_assets) / sizeof(hot_assets[0]));
+    }
+}
+
+bool ui_weather_preload(void)
+{
+    if (page) {
+        return true;
+    }
+    if (!preloading) {
+        ui_desc_build_begin(&builder, lv_scr_act(), weather_desc, OBJ_NUM, objs);
+        preloading = true;
+    }
+    return ui_desc_build_step(&builder);
+}
+
+void ui_weather_discard(void)
+{
+    if (preloading) {
+        preloading = false;
+        if (builder.next) {
+            lv_obj_del(objs[0]);
+        }
+    }
 }
 
 void ui_weather_delete(void)
@@ -115,10 +240,22 @@ void ui_weather_delete(void)
         ui_remove_all_objs_from_encoder_group();
         lv_obj_del(page);
         page = NULL;
+        ui_sprite_sheet_delete(sun_sheet);
+        sun_sheet = NULL;
         if (return_callback) {
             return_callback(NULL);
         }
     }
 }
 
-
+bool ui_weather_get_sprite_stats(ui_sprite_stats_t *stats)
+{
+    /* the player updates the stats and the sheet comes and goes with the page */
+    lvgl_sem_take();
+    bool shown = (sun_sheet != NULL);
+    if (shown) {
+        ui_sprite_get_stats(sun_sheet, stats);
+    }
+    lvgl_sem_give();
+    return shown;
+}
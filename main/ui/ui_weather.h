@@ -1,6 +1,8 @@
 #ifndef UI_WEATHER_H__
 #define UI_WEATHER_H__
 
+#include "ui_sprite.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -8,6 +10,22 @@ extern "C" {
 void ui_weather_init(ret_cb_t ret_cb);
 void ui_weather_delete(void);
 
+/**
+ * Build the page hidden, one object per call, so that ui_weather_init() only has to show it.
+ * @return true once the page is complete
+ */
+bool ui_weather_preload(void);
+
+/**
+ * Drop a page built by ui_weather_preload() that won't be shown.
+ */
+void ui_weather_discard(void);
+
+/**
+ * @return false while the page isn't shown with its icon sheet
+ */
+bool ui_weather_get_sprite_stats(ui_sprite_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Decode binary records of main/dlog.c (dlog_init(true)) from a serial log.
+
+    idf.py monitor | tee log.txt
+    python tools/dlog_decode.py build/knob_panel.elf log.txt
+
+Record lines start with "~D", all other lines are passed through unchanged.
+Needs pyelftools, which comes with ESP-IDF.
+"""
+
+import argparse
+import re
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+FMT_SPEC = re.compile(r'%([-+ #0]*)(\d*|\*)(\.\d+)?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class Strings:
+    def __init__(self, path):
+        self.sections = []
+        with open(path, 'rb') as f:
+            elf = ELFFile(f)
+            for sec in elf.iter_sections():
+                if sec['sh_flags'] & 0x2 and sec['sh_type'] != 'SHT_NOBITS':  # SHF_ALLOC
+                    self.sections.append((sec['sh_addr'], sec.data()))
+        self.cache = {}
+
+    def get(self, addr):
+        if addr == 0:
+            return '(null)'
+        if addr in self.cache:
+            return self.cache[addr]
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                s = data[addr - base:end].decode('utf-8', 'replace')
+                self.cache[addr] = s
+                return s
+        return '<0x%08x>' % addr
+
+
+def to_signed(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def format_record(strings, fmt, args):
+    out = []
+    pos = 0
+    it = iter(args)
+    for m in FMT_SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        v = next(it, 0)
+        spec = '%' + flags + width + (prec or '')
+        if conv == 's':
+            out.append((spec + 's') % strings.get(v))
+        elif conv == 'p':
+            out.append('0x%08x' % v)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(v & 0xff))
+        elif conv in 'di':
+            out.append((spec + 'd') % to_signed(v))
+        elif conv == 'u':
+            out.append((spec + 'd') % v)
+        else:
+            out.append((spec + conv) % v)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', help='application ELF the log was produced with')
+    parser.add_argument('log', nargs='?', help='serial log, stdin if omitted')
+    args = parser.parse_args()
+
+    strings = Strings(args.elf)
+    src = open(args.log, errors='replace') if args.log else sys.stdin
+    for line in src:
+        idx = line.find('~D ')
+        if idx < 0:
+            sys.stdout.write(line)
+            continue
+        fields = [int(x, 16) for x in line[idx + 3:].split()]
+        if len(fields) < 4:
+            sys.stdout.write(line)
+            continue
+        time_ms, fmt, tag, suppressed = fields[:4]
+        text = format_record(strings, strings.get(fmt), fields[4:])
+        tail = ' (+%d suppressed)' % suppressed if suppressed else ''
+        sys.stdout.write('%s[%u] %s: %s%s\n' % (line[:idx], time_ms, strings.get(tag) if tag else '-', text, tail))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""Estimate the fastest rotation components/bsp/bsp_indev.c decodes without losing detents.
+
+    python tools/encoder_stress.py
+    python tools/encoder_stress.py --latency-us 1000 --queue 10 --max-rpm 600
+
+Synthesizes ideal quadrature edge streams at increasing RPM and runs them through a model
+of the encoder path: the ISR samples both pins and posts them with the pin number to a
+queue of --queue entries, the encoder task is woken --latency-us after the edge (the ISR
+doesn't request a yield, so this is up to one FreeRTOS tick) and spends --service-us per
+queued edge. The decoder below mirrors gpioTaskExample() and quad_track(), keep them in
+sync.
+
+Prints the same counters as bsp_encoder_get_stats() for every speed and the highest RPM
+where the value still matched the detents turned. Contact bounce isn't modelled.
+
+    python tools/encoder_stress.py --check
+
+runs fixed cases, some of them overflowing the queue, and fails if missed detents reads
+non-zero without a loss, zero with one, or more than the value is short by. It is a lower
+bound: after a lost edge the decoder pairs the next edges wrongly and can drop more.
+"""
+
+import argparse
+import collections
+
+PIN_A = 0
+PIN_B = 1
+
+
+class Decoder:
+    """gpioTaskExample() of bsp_indev.c, with the stats of quad_track()."""
+
+    def __init__(self, a, b):
+        self.value = 0
+        self.a_old, self.b_old = a, b
+        self.a_change = self.b_change = False
+        self.dir = 0
+        self.quad_state = (a << 1) | b
+        self.overflows_seen = 0
+        self.overflows_unseen = 0
+        self.lost_edges = 0
+        self.edges = self.invalid = self.missed = 0
+
+    def quad_track(self, a, b, overflows):
+        lost = overflows - self.overflows_seen
+        self.overflows_seen = overflows
+        self.overflows_unseen += lost
+        self.lost_edges += lost
+        state = (a << 1) | b
+        diff = state ^ self.quad_state
+        if diff in (0, 3):
+            self.invalid += 1
+            if self.overflows_unseen:
+                self.overflows_unseen = 0
+            else:
+                self.lost_edges += 1
+        self.quad_state = state
+        self.missed = (self.lost_edges + 1) // 2
+
+    def edge(self, pin, a, b, overflows):
+        self.edges += 1
+        self.quad_track(a, b, overflows)
+        if pin == PIN_A:
+            if a != self.a_old:
+                self.a_old = a
+                self.a_change = True
+                if not self.b_change:
+                    self.dir = 1 if self.a_old != self.b_old else -1
+        else:
+            if b != self.b_old:
+                self.b_old = b
+                self.b_change = True
+                if not self.a_change:
+                    self.dir = -1 if self.a_old != self.b_old else 1
+        if self.a_change and self.b_change:
+            self.value += self.dir
+            self.a_change = self.b_change = False
+            self.dir = 0
+
+
+def edge_stream(rpm, detents, turns):
+    """(time_us, pin) of every edge, turning up (A leads). Each detent is two edges."""
+    edges_per_s = rpm / 60.0 * detents * 2
+    period_us = 1e6 / edges_per_s
+    a = b = 0
+    for k in range(int(turns * detents * 2)):
+        # 00 -> 10 -> 11 -> 01 -> 00 is the INC direction of the decoder
+        pin = PIN_A if k % 2 == 0 else PIN_B
+        yield (k + 1) * period_us, pin
+
+
+def run(rpm, args):
+    edges = []      # (time_us, pin, a, b), the levels as the ISR samples them
+    a = b = 0
+    for t, pin in edge_stream(rpm, args.detents, args.turns):
+        if pin == PIN_A:
+            a ^= 1
+        else:
+            b ^= 1
+        edges.append((t, pin, a, b))
+
+    dec = Decoder(0, 0)
+    queue = collections.deque()
+    overflows = 0
+    task_free = 0.0     # the task is busy until then
+    wake = None         # when the task starts on the queued edges
+    i = 0
+    while i < len(edges) or queue:
+        next_edge = edges[i][0] if i < len(edges) else float('inf')
+        if queue and wake is not None and wake <= next_edge:
+            t = max(wake, task_free)
+            pin, sa, sb = queue.popleft()
+            dec.edge(pin, sa, sb, overflows)
+            task_free = t + args.service_us
+            wake = task_free if queue else None
+            continue
+        t, pin, sa, sb = edges[i]
+        i += 1
+        if len(queue) >= args.queue:
+            overflows += 1
+            continue
+        queue.append((pin, sa, sb))
+        if wake is None:
+            wake = max(t + args.latency_us, task_free)
+
+    expected = len(edges) // 2
+    return dec, overflows, expected
+
+
+# (rpm, latency_us, queue, overflows expected)
+CHECK_CASES = [
+    (600, 1000, 10, False),
+    (15000, 1000, 10, False),
+    (18000, 1000, 10, True),
+    (1800, 10000, 10, True),
+    (1800, 3000, 3, True),
+]
+
+
+def check(args):
+    failed = 0
+    print('rpm\tlatency\tqueue\toverflows\tinvalid\tmissed\tvalue/expected')
+    for rpm, latency_us, queue, overflowing in CHECK_CASES:
+        args.latency_us, args.queue = latency_us, queue
+        dec, overflows, expected = run(rpm, args)
+        short = expected - dec.value
+        ok = (overflows > 0) == overflowing and (dec.missed > 0) == (short > 0) \
+            and dec.missed <= short
+        print('%d\t%d\t%d\t%d\t%d\t%d\t%d/%d\t%s' % (rpm, latency_us, queue, overflows,
+                                                   dec.invalid, dec.missed, dec.value, expected,
+                                                   'ok' if ok else 'FAIL'))
+        failed += not ok
+    return 1 if failed else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--detents', type=int, default=20, help='detents per revolution')
+    parser.add_argument('--queue', type=int, default=10, help='gpioEventQueue length')
+    parser.add_argument('--latency-us', type=float, default=1000, help='edge to task wake-up')
+    parser.add_argument('--service-us', type=float, default=20, help='task time per edge')
+    parser.add_argument('--turns', type=float, default=2, help='revolutions per speed')
+    parser.add_argument('--min-rpm', type=int, default=10)
+    parser.add_argument('--max-rpm', type=int, default=600)
+    parser.add_argument('--step-rpm', type=int, default=10)
+    parser.add_argument('--check', action='store_true', help='run the fixed cases')
+    args = parser.parse_args()
+
+    if args.check:
+        return check(args)
+
+    last = None
+    print('rpm\tedges\toverflows\tinvalid\tmissed\tvalue/expected')
+    reliable = None
+    for rpm in range(args.min_rpm, args.max_rpm + 1, args.step_rpm):
+        dec, overflows, expected = run(rpm, args)
+        last = rpm
+        print('%d\t%d\t%d\t%d\t%d\t%d/%d' % (rpm, dec.edges, overflows, dec.invalid, dec.missed,
+                                          dec.value, expected))
+        if dec.value == expected and not overflows and not dec.invalid:
+            if reliable == rpm - args.step_rpm or reliable is None and rpm == args.min_rpm:
+                reliable = rpm
+    if reliable is None:
+        print('no reliable speed in the range')
+    elif reliable == last:
+        print('no limit found up to %d rpm, raise --max-rpm' % reliable)
+    else:
+        print('max reliable: %d rpm (%d detents/s)' % (reliable, reliable * args.detents // 60))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())